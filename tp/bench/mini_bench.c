@@ -0,0 +1,812 @@
+/**
+ * @file mini_bench.c
+ * @brief Throughput measurements for mini_lib.
+ *
+ * Each benchmark is selected by name on the command line, e.g.
+ * `./mini_bench utf8`. Without argument, every benchmark is run.
+ */
+
+// include standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// include personal library
+#include "mini_lib.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_rate(const char* name, double bytes, double seconds) {
+    printf("%-32s %10.1f MB/s\n", name, bytes / seconds / 1e6);
+}
+
+// Reference: decode every code point one byte at a time
+static int scalar_decode_count(const unsigned char* s, int len) {
+    int i = 0, count = 0;
+    while (i < len) {
+        unsigned char c = s[i];
+        int n = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        if (c >= 0x80 && (c < 0xC2 || c > 0xF4)) return -1;
+        if (i + n > len) return -1;
+        int cp = n == 1 ? c : c & (0x7F >> n);
+        for (int k = 1; k < n; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return -1;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        if ((n == 3 && cp < 0x800) || (n == 4 && (cp < 0x10000 || cp > 0x10FFFF))
+            || (cp >= 0xD800 && cp <= 0xDFFF)) return -1;
+        i += n;
+        count++;
+    }
+    return count;
+}
+
+static void bench_utf8(void) {
+    printf("== utf8 (16 MB, mostly ASCII log text then mixed French/CJK) ==\n");
+    const char* samples[2] = {
+        "2024-11-14 12:00:01 INFO request served in 12 ms path=/index.html\n",
+        "r\xc3\xa9sum\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e caract\xc3\xa8re \xf0\x9f\x98\x80 fin\n",
+    };
+    int len = 16 << 20;
+    unsigned char* data = malloc(len);
+    for (int s = 0; s < 2; s++) {
+        int pos = 0, sample_len = strlen(samples[s]);
+        while (pos + sample_len <= len) {
+            memcpy(data + pos, samples[s], sample_len);
+            pos += sample_len;
+        }
+        memset(data + pos, ' ', len - pos);
+
+        int rounds = 20, sink = 0;
+        double t = now();
+        for (int r = 0; r < rounds; r++) sink += scalar_decode_count(data, len);
+        print_rate(s ? "  mixed scalar decode+validate" : "  ascii scalar decode+validate", (double)len * rounds, now() - t);
+        t = now();
+        for (int r = 0; r < rounds; r++) sink += mini_utf8_validate(data, len);
+        print_rate(s ? "  mixed mini_utf8_validate" : "  ascii mini_utf8_validate", (double)len * rounds, now() - t);
+        t = now();
+        for (int r = 0; r < rounds; r++) sink += mini_utf8_count(data, len);
+        print_rate(s ? "  mixed mini_utf8_count" : "  ascii mini_utf8_count", (double)len * rounds, now() - t);
+        t = now();
+        for (int r = 0; r < rounds; r++) sink += mini_utf8_width(data, len);
+        print_rate(s ? "  mixed mini_utf8_width" : "  ascii mini_utf8_width", (double)len * rounds, now() - t);
+        if (sink == 42) printf(" ");
+    }
+    free(data);
+}
+
+#define BENCH_FILE "mini_bench.tmp"
+
+// Creates BENCH_FILE with size bytes of printable data
+static void make_bench_file(long size) {
+    MYFILE* file = mini_fopen(BENCH_FILE, 'w');
+    char chunk[4096];
+    for (int i = 0; i < (int)sizeof(chunk); i++) chunk[i] = 'a' + i % 26;
+    for (long done = 0; done < size; done += sizeof(chunk)) {
+        mini_fwrite(chunk, 1, sizeof(chunk), file);
+    }
+    mini_fclose(file);
+}
+
+static void bench_fread(void) {
+    long size = 32L << 20;
+    printf("== fread (32 MB file in page cache, element size sweep) ==\n");
+    make_bench_file(size);
+    char* record = malloc(4096);
+    for (int element = 1; element <= 4096; element *= 4) {
+        MYFILE* file = mini_fopen(BENCH_FILE, 'r');
+        double t = now();
+        long total = 0;
+        int got;
+        while ((got = mini_fread(record, element, 1, file)) > 0) total += got;
+        double elapsed = now() - t;
+        mini_fclose(file);
+        char name[64];
+        snprintf(name, sizeof(name), "  mini_fread %4d B elements", element);
+        print_rate(name, (double)total, elapsed);
+    }
+    free(record);
+    unlink(BENCH_FILE);
+}
+
+static void bench_bulk(void) {
+    long size = 256L << 20;
+    int chunk = 1 << 20;
+    printf("== bulk (256 MB in 1 MB mini_fread/mini_fwrite calls) ==\n");
+    char* data = malloc(chunk);
+    memset(data, 'x', chunk);
+    MYFILE* file = mini_fopen(BENCH_FILE, 'w');
+    double t = now();
+    for (long done = 0; done < size; done += chunk) mini_fwrite(data, 1, chunk, file);
+    mini_fclose(file);
+    print_rate("  mini_fwrite 1 MB", (double)size, now() - t);
+    file = mini_fopen(BENCH_FILE, 'r');
+    t = now();
+    long total = 0;
+    int got;
+    while ((got = mini_fread(data, 1, chunk, file)) > 0) total += got;
+    print_rate("  mini_fread 1 MB (page cache)", (double)total, now() - t);
+    mini_fclose(file);
+    free(data);
+    unlink(BENCH_FILE);
+}
+
+static void bench_vbuf(void) {
+    long size = 256L << 20;
+    int record = 100;
+    printf("== setvbuf (256 MB in 100 B records, buffer size sweep) ==\n");
+    char data[100];
+    memset(data, 'v', sizeof(data));
+    for (int buffer_size = 4 << 10; buffer_size <= 4 << 20; buffer_size *= 4) {
+        MYFILE* file = mini_fopen(BENCH_FILE, 'w');
+        mini_setvbuf(file, NULL, MINI_IOFBF, buffer_size);
+        double t = now();
+        for (long done = 0; done < size; done += record) mini_fwrite(data, 1, record, file);
+        mini_fclose(file);
+        double write_time = now() - t;
+
+        file = mini_fopen(BENCH_FILE, 'r');
+        mini_setvbuf(file, NULL, MINI_IOFBF, buffer_size);
+        t = now();
+        long total = 0;
+        int got;
+        while ((got = mini_fread(data, 1, record, file)) > 0) total += got;
+        mini_fclose(file);
+        printf("  %5d KB buffer   write %8.1f MB/s   read %8.1f MB/s\n", buffer_size >> 10,
+               size / write_time / 1e6, total / (now() - t) / 1e6);
+    }
+    unlink(BENCH_FILE);
+}
+
+static void bench_mmap(void) {
+    long size = 256L << 20;
+    int chunk = 64 << 10;
+    printf("== mmap (256 MB in page cache) ==\n");
+    make_bench_file(size);
+    char* data = malloc(chunk);
+    char modes[2] = {'r', 'm'};
+    int calls[2] = {100, chunk};
+    for (int c = 0; c < 2; c++) {
+        for (int m = 0; m < 2; m++) {
+            MYFILE* file = mini_fopen(BENCH_FILE, modes[m]);
+            double t = now();
+            long total = 0;
+            int got;
+            while ((got = mini_fread(data, 1, calls[c], file)) > 0) total += got;
+            char name[64];
+            snprintf(name, sizeof(name), "  mini_fread %5d B mode '%c'", calls[c], modes[m]);
+            print_rate(name, (double)total, now() - t);
+            mini_fclose(file);
+        }
+    }
+    // Zero-copy: scan the mapping in place (the file holds no newline)
+    MYFILE* file = mini_fopen(BENCH_FILE, 'm');
+    double t = now();
+    long len;
+    char* view = mini_fmap_view(file, &len);
+    for (long pos = 0; pos < len; pos += chunk) {
+        if (mini_memchr(view + pos, '\n', len - pos < chunk ? len - pos : chunk)) printf(" ");
+    }
+    print_rate("  mini_fmap_view + mini_memchr", (double)len, now() - t);
+    mini_fclose(file);
+    free(data);
+    unlink(BENCH_FILE);
+}
+
+static void bench_async(void) {
+    int files = 64, chunk = 64 << 10;
+    long file_size = 4L << 20;
+    printf("== async (64 files x 4 MB, 64 KB requests, one in flight per file) ==\n");
+    MYFILE* streams[64];
+    char* buffers[64];
+    char name[64];
+    for (int f = 0; f < files; f++) {
+        make_bench_file(file_size);
+        snprintf(name, sizeof(name), "mini_bench_%d.tmp", f);
+        rename(BENCH_FILE, name);
+        buffers[f] = malloc(chunk);
+    }
+
+    for (int f = 0; f < files; f++) {
+        snprintf(name, sizeof(name), "mini_bench_%d.tmp", f);
+        streams[f] = mini_fopen(name, 'r');
+    }
+    double t = now();
+    long total = 0;
+    for (long offset = 0; offset < file_size; offset += chunk) {
+        for (int f = 0; f < files; f++) total += mini_fread(buffers[f], 1, chunk, streams[f]);
+    }
+    print_rate("  mini_fread round robin", (double)total, now() - t);
+    for (int f = 0; f < files; f++) mini_fclose(streams[f]);
+
+    int backends[2] = {MINI_AIO_URING, MINI_AIO_THREADS};
+    for (int b = 0; b < 2; b++) {
+        if (mini_async_init(files, backends[b]) != backends[b]) continue;
+        for (int f = 0; f < files; f++) {
+            snprintf(name, sizeof(name), "mini_bench_%d.tmp", f);
+            streams[f] = mini_fopen(name, 'r');
+        }
+        t = now();
+        total = 0;
+        for (long offset = 0; offset < file_size; offset += chunk) {
+            // One batch of 64 reads, one submission
+            for (int f = 0; f < files; f++) mini_fread_async(streams[f], buffers[f], chunk, offset);
+            mini_async_submit();
+            int id, result;
+            while (mini_async_complete(&id, &result, 1) == 1) total += result;
+        }
+        print_rate(b ? "  mini_fread_async thread pool" : "  mini_fread_async io_uring", (double)total, now() - t);
+        for (int f = 0; f < files; f++) mini_fclose(streams[f]);
+        mini_async_shutdown();
+    }
+    for (int f = 0; f < files; f++) {
+        snprintf(name, sizeof(name), "mini_bench_%d.tmp", f);
+        unlink(name);
+        free(buffers[f]);
+    }
+}
+
+// Drops the pages of BENCH_FILE from the page cache
+static void evict_bench_file(void) {
+    int fd = open(BENCH_FILE, O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Stand-in for per-block processing: a few multiply-add passes over the data
+static unsigned long process_block(const unsigned char* data, int len, int passes) {
+    unsigned long hash = 0;
+    for (int p = 0; p < passes; p++) {
+        for (int i = 0; i < len; i++) hash = hash * 31 + data[i];
+    }
+    return hash;
+}
+
+static void bench_readahead(void) {
+    long size = 1L << 30;
+    int chunk = 64 << 10;
+    printf("== readahead (1 GB file, cold cache via POSIX_FADV_DONTNEED, 64 KB mini_fread) ==\n");
+    make_bench_file(size);
+    unsigned char* data = malloc(chunk);
+    unsigned long sink = 0;
+    int passes[2] = {0, 1};
+    for (int p = 0; p < 2; p++) {
+        for (int ahead = 0; ahead < 2; ahead++) {
+            evict_bench_file();
+            MYFILE* file = mini_fopen(BENCH_FILE, 'r');
+            if (ahead) mini_freadahead(file, 1);
+            double t = now();
+            long total = 0;
+            int n;
+            while ((n = mini_fread(data, 1, chunk, file)) > 0) {
+                sink += process_block(data, n, passes[p]);
+                total += n;
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "  %s, %s", passes[p] ? "with compute" : "read only",
+                     ahead ? "read-ahead" : "plain");
+            print_rate(name, (double)total, now() - t);
+            mini_fclose(file);
+        }
+    }
+    if (sink == 42) printf(" ");
+    free(data);
+    unlink(BENCH_FILE);
+}
+
+static void bench_getline(void) {
+    long size = 1L << 30;
+    printf("== getline (1 GB log file in page cache) ==\n");
+    const char* samples[3] = {
+        "2024-11-14 12:00:01 INFO request served in 12 ms path=/index.html\n",
+        "2024-11-14 12:00:02 WARN slow upstream\n",
+        "2024-11-14 12:00:03 DEBUG headers: accept=text/html,application/xhtml+xml user-agent=Mozilla/5.0 (X11; Linux x86_64)\n",
+    };
+    MYFILE* out = mini_fopen(BENCH_FILE, 'w');
+    long written = 0;
+    for (int i = 0; written < size; i++) {
+        const char* line = samples[i % 3];
+        int len = strlen(line);
+        mini_fwrite((void*)line, 1, len, out);
+        written += len;
+    }
+    mini_fclose(out);
+
+    FILE* std = fopen(BENCH_FILE, "r");
+    char* line = NULL;
+    size_t capacity = 0;
+    long lines = 0;
+    double t = now();
+    while (getline(&line, &capacity, std) > 0) lines++;
+    double elapsed = now() - t;
+    printf("  %-30s %10.1f Mlines/s  %8.1f MB/s\n", "getline", lines / elapsed / 1e6, written / elapsed / 1e6);
+    free(line);
+    fclose(std);
+
+    char modes[2] = {'r', 'm'};
+    for (int m = 0; m < 2; m++) {
+        MYFILE* file = mini_fopen(BENCH_FILE, modes[m]);
+        int len;
+        lines = 0;
+        t = now();
+        while (mini_fgetline(file, &len)) lines++;
+        elapsed = now() - t;
+        printf("  %-30s %10.1f Mlines/s  %8.1f MB/s\n", m ? "mini_fgetline mapped" : "mini_fgetline buffered",
+               lines / elapsed / 1e6, written / elapsed / 1e6);
+        mini_fclose(file);
+    }
+    unlink(BENCH_FILE);
+}
+
+#define LOCK_RECORDS (4 << 20)
+#define LOCK_BATCH 256
+
+typedef struct {
+    MYFILE* file;
+    int records;
+    int mode;   // 0: mini_fwrite, 1: mini_fwrite_unlocked, 2: batches under mini_flockfile
+} LockJob;
+
+static void* write_records(void* arg) {
+    LockJob* job = (LockJob*)arg;
+    char record[16] = "0123456789abcde\n";
+    for (int i = 0; i < job->records; i += LOCK_BATCH) {
+        if (job->mode == 2) mini_flockfile(job->file);
+        for (int k = 0; k < LOCK_BATCH; k++) {
+            if (job->mode == 0) mini_fwrite(record, 1, sizeof(record), job->file);
+            else mini_fwrite_unlocked(record, 1, sizeof(record), job->file);
+        }
+        if (job->mode == 2) mini_funlockfile(job->file);
+    }
+    return NULL;
+}
+
+static void bench_lock(void) {
+    printf("== lock (4M x 16-byte records, one shared stream) ==\n");
+    const char* names[3] = {"mini_fwrite", "mini_fwrite_unlocked", "flockfile/256 + unlocked"};
+    for (int threads = 1; threads <= 4; threads += 3) {
+        for (int mode = 0; mode < 3; mode++) {
+            if (threads > 1 && mode == 1) continue; // Not safe when shared
+            MYFILE* file = mini_fopen(BENCH_FILE, 'w');
+            LockJob job = {file, LOCK_RECORDS / threads, mode};
+            pthread_t ids[4];
+            double t = now();
+            for (int k = 0; k < threads; k++) pthread_create(&ids[k], NULL, write_records, &job);
+            for (int k = 0; k < threads; k++) pthread_join(ids[k], NULL);
+            mini_fflush(file);
+            char name[64];
+            snprintf(name, sizeof(name), "  %d thread%s, %s", threads, threads > 1 ? "s" : "", names[mode]);
+            print_rate(name, 16.0 * LOCK_RECORDS, now() - t);
+            mini_fclose(file);
+        }
+    }
+    unlink(BENCH_FILE);
+}
+
+static void bench_registry(void) {
+    int count = 15000;
+    printf("== registry (%d streams open at once, closed in open order) ==\n", count);
+    make_bench_file(4096);
+    MYFILE** streams = malloc(sizeof(MYFILE*) * count);
+    double t = now();
+    for (int i = 0; i < count; i++) streams[i] = mini_fopen(BENCH_FILE, 'r');
+    double opened = now() - t;
+    t = now();
+    mini_exit_flush();
+    double flushed = now() - t;
+    t = now();
+    for (int i = 0; i < count; i++) mini_fclose(streams[i]);
+    double closed = now() - t;
+    printf("  %-30s %10.1f ms\n", "open all", opened * 1e3);
+    printf("  %-30s %10.3f ms\n", "mini_exit_flush, none dirty", flushed * 1e3);
+    printf("  %-30s %10.1f ms\n", "close all", closed * 1e3);
+    free(streams);
+    unlink(BENCH_FILE);
+}
+
+// Share of BENCH_FILE currently held in the page cache, in percent
+static double cached_percent(long size) {
+    int fd = open(BENCH_FILE, O_RDONLY);
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    long pages = (size + 4095) / 4096, resident = 0;
+    unsigned char* vec = malloc(pages);
+    mincore(map, size, vec);
+    for (long i = 0; i < pages; i++) resident += vec[i] & 1;
+    free(vec);
+    munmap(map, size);
+    close(fd);
+    return 100.0 * resident / pages;
+}
+
+static void bench_direct(void) {
+    long size = 1L << 30;
+    int chunk = 64 << 10;
+    printf("== direct (1 GB sequential write then cold read, 64 KB calls) ==\n");
+    char* data = malloc(chunk);
+    memset(data, 'd', chunk);
+    char modes[2][2] = {{'w', 'r'}, {'D', 'd'}};
+    for (int m = 0; m < 2; m++) {
+        unlink(BENCH_FILE);
+        MYFILE* file = mini_fopen(BENCH_FILE, modes[m][0]);
+        double t = now();
+        for (long done = 0; done < size; done += chunk) mini_fwrite(data, 1, chunk, file);
+        mini_fclose(file);
+        int fd = open(BENCH_FILE, O_RDONLY);
+        fdatasync(fd); // Both modes pay for reaching the disk
+        close(fd);
+        double elapsed = now() - t;
+        printf("  %-30s %10.1f MB/s  %5.1f%% of file cached after\n", m ? "write 'D'" : "write 'w'",
+               size / elapsed / 1e6, cached_percent(size));
+
+        evict_bench_file();
+        file = mini_fopen(BENCH_FILE, modes[m][1]);
+        long total = 0;
+        int n;
+        t = now();
+        while ((n = mini_fread(data, 1, chunk, file)) > 0) total += n;
+        elapsed = now() - t;
+        mini_fclose(file);
+        printf("  %-30s %10.1f MB/s  %5.1f%% of file cached after\n", m ? "read 'd'" : "read 'r'",
+               total / elapsed / 1e6, cached_percent(size));
+    }
+    free(data);
+    unlink(BENCH_FILE);
+}
+
+static void bench_copy(void) {
+    long size = 1L << 30;
+    int chunk = 64 << 10;
+    printf("== copy (1 GB file to file, page cache warm) ==\n");
+    make_bench_file(size);
+    char* data = malloc(chunk);
+    for (int m = 0; m < 2; m++) {
+        MYFILE* src = mini_fopen(BENCH_FILE, 'r');
+        MYFILE* dst = mini_fopen("mini_bench_copy.tmp", 'w');
+        double t = now();
+        long total = 0;
+        if (m == 0) {
+            int n;
+            while ((n = mini_fread(data, 1, chunk, src)) > 0) total += mini_fwrite(data, 1, n, dst);
+        } else {
+            total = mini_fcopy(dst, src, -1);
+        }
+        mini_fclose(dst);
+        print_rate(m ? "  mini_fcopy" : "  mini_fread + mini_fwrite 64 KB", (double)total, now() - t);
+        mini_fclose(src);
+        unlink("mini_bench_copy.tmp");
+    }
+    free(data);
+    unlink(BENCH_FILE);
+}
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} Benchmark;
+
+typedef struct {
+    MYFILE* file;
+    int first, step, blocks;
+    long bytes;
+} LzJob;
+
+static void* read_lz_blocks(void* arg) {
+    LzJob* job = (LzJob*)arg;
+    char* block = malloc(1 << 20);
+    for (int b = job->first; b < job->blocks; b += job->step) {
+        int n = mini_fzread_block(job->file, b, block, 1 << 20);
+        if (n > 0) job->bytes += n;
+    }
+    free(block);
+    return NULL;
+}
+
+static void bench_lz(void) {
+    long size = 256L << 20;
+    int chunk = 64 << 10;
+    printf("== lz (256 MB of log lines, evicted before each read) ==\n");
+    // 4 MB of lines with the same shape and varying fields, written in a loop
+    int pool_size = 4 << 20;
+    char* pool = malloc(pool_size + 128);
+    unsigned int seed = 1;
+    for (int len = 0; len < pool_size;) {
+        seed = seed * 1103515245 + 12345;
+        len += snprintf(pool + len, 128, "2024-05-%02u 12:%02u:%02u INFO worker-%u request id=%u status=%u\n",
+                        seed % 28 + 1, (seed >> 8) % 60, (seed >> 14) % 60, (seed >> 20) % 16, seed, 200 + (seed >> 4) % 5);
+    }
+    char* data = malloc(chunk);
+    const char* names[2] = {"plain", "lz"};
+    const char* paths[2] = {"mini_bench_plain.tmp", "mini_bench_lz.tmp"};
+    for (int m = 0; m < 2; m++) {
+        MYFILE* file = mini_fopen((char*)paths[m], m ? 'Z' : 'w');
+        double t = now();
+        for (long done = 0; done < size; done += chunk) {
+            mini_fwrite(pool + done % pool_size, 1, chunk, file);
+        }
+        mini_fclose(file);
+        double written = now() - t;
+        struct stat info;
+        stat(paths[m], &info);
+        char label[64];
+        snprintf(label, sizeof(label), "  %s write (%ld MB on disk)", names[m], (long)(info.st_size >> 20));
+        print_rate(label, (double)size, written);
+
+        int fd = open(paths[m], O_RDONLY);
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        file = mini_fopen((char*)paths[m], m ? 'z' : 'r');
+        t = now();
+        long total = 0;
+        int n;
+        while ((n = mini_fread(data, 1, chunk, file)) > 0) total += n;
+        snprintf(label, sizeof(label), "  %s read", names[m]);
+        print_rate(label, (double)total, now() - t);
+        mini_fclose(file);
+    }
+
+    // Blocks decoded in parallel, each thread with its own block numbers
+    MYFILE* file = mini_fopen((char*)paths[1], 'z');
+    int blocks = mini_fzblocks(file);
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        pthread_t ids[4];
+        LzJob jobs[4];
+        double t = now();
+        long total = 0;
+        for (int i = 0; i < threads; i++) {
+            jobs[i] = (LzJob){file, i, threads, blocks, 0};
+            pthread_create(&ids[i], NULL, read_lz_blocks, &jobs[i]);
+        }
+        for (int i = 0; i < threads; i++) {
+            pthread_join(ids[i], NULL);
+            total += jobs[i].bytes;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "  mini_fzread_block, %d thread(s)", threads);
+        print_rate(label, (double)total, now() - t);
+    }
+    mini_fclose(file);
+    free(pool);
+    free(data);
+    unlink(paths[0]);
+    unlink(paths[1]);
+}
+
+static void* open_read_close(void* arg) {
+    long rounds = (long)arg;
+    char data[1024];
+    for (long i = 0; i < rounds; i++) {
+        MYFILE* file = mini_fopen("mini_bench_small.tmp", 'r');
+        mini_fread(data, 1, sizeof(data), file);
+        mini_fclose(file);
+    }
+    return NULL;
+}
+
+static void bench_pool(void) {
+    long rounds = 200000;
+    printf("== pool (open, read 1 KB, close) ==\n");
+    int fd = open("mini_bench_small.tmp", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    char data[1024];
+    memset(data, 'x', sizeof(data));
+    write(fd, data, sizeof(data));
+    close(fd);
+    // Streams kept open in between, as a server would: their buffers stay
+    // allocated while the loop churns
+    MYFILE* idle[64];
+    for (int i = 0; i < 64; i++) {
+        idle[i] = mini_fopen("mini_bench_small.tmp", 'r');
+        mini_fread(data, 1, 1, idle[i]);
+    }
+    for (int threads = 1; threads <= 4; threads *= 4) {
+        pthread_t ids[4];
+        double t = now();
+        for (int i = 0; i < threads; i++) {
+            pthread_create(&ids[i], NULL, open_read_close, (void*)(rounds / threads));
+        }
+        for (int i = 0; i < threads; i++) pthread_join(ids[i], NULL);
+        double elapsed = now() - t;
+        char label[32];
+        snprintf(label, sizeof(label), "%d thread(s)", threads);
+        printf("  %-30s %10.0f ns per file\n", label, elapsed * 1e9 / rounds);
+    }
+    for (int i = 0; i < 64; i++) mini_fclose(idle[i]);
+    unlink("mini_bench_small.tmp");
+}
+
+typedef struct {
+    MYFILE* file;
+    int records;
+} SyncJob;
+
+static void* sync_records(void* arg) {
+    SyncJob* job = (SyncJob*)arg;
+    char record[100];
+    memset(record, 'r', sizeof(record) - 1);
+    record[sizeof(record) - 1] = '\n';
+    for (int i = 0; i < job->records; i++) {
+        mini_fwrite(record, 1, sizeof(record), job->file);
+        mini_fflush(job->file);
+    }
+    return NULL;
+}
+
+static void bench_sync(void) {
+    int records = 20000;
+    printf("== sync (4 threads, 100 B record + mini_fflush each) ==\n");
+    const char* names[5] = {"none", "fdatasync per flush", "periodic 10 ms", "group, no window", "group, 200 us window"};
+    int modes[5] = {MINI_SYNC_NONE, MINI_SYNC_FLUSH, MINI_SYNC_PERIODIC, MINI_SYNC_GROUP, MINI_SYNC_GROUP};
+    int intervals[5] = {0, 0, 10000, 0, 200};
+    for (int m = 0; m < 5; m++) {
+        MYFILE* file = mini_fopen("mini_bench_sync.tmp", 'w');
+        mini_fsetsync(file, modes[m], intervals[m]);
+        pthread_t ids[4];
+        SyncJob job = {file, records / 4};
+        double t = now();
+        for (int i = 0; i < 4; i++) pthread_create(&ids[i], NULL, sync_records, &job);
+        for (int i = 0; i < 4; i++) pthread_join(ids[i], NULL);
+        mini_iostats stats;
+        mini_fstats(file, &stats);
+        mini_fclose(file);
+        double elapsed = now() - t;
+        printf("  %-30s %10.0f records/s  %6ld fdatasync\n", names[m], records / elapsed, stats.syncs);
+    }
+    unlink("mini_bench_sync.tmp");
+}
+
+static void bench_mapw(void) {
+    long size = 1L << 30;
+    printf("== mapw (1 GB written, close included) ==\n");
+    char* data = malloc(64 << 10);
+    memset(data, 'w', 64 << 10);
+    int records[3] = {256, 4096, 64 << 10};
+    for (int r = 0; r < 3; r++) {
+        for (int m = 0; m < 2; m++) {
+            MYFILE* file = mini_fopen("mini_bench_mapw.tmp", m ? 'M' : 'w');
+            double t = now();
+            for (long done = 0; done < size; done += records[r]) {
+                mini_fwrite(data, 1, records[r], file);
+            }
+            mini_fclose(file);
+            char label[64];
+            snprintf(label, sizeof(label), "  %s, %d B records", m ? "'M'" : "'w'", records[r]);
+            print_rate(label, (double)size, now() - t);
+            unlink("mini_bench_mapw.tmp");
+        }
+    }
+    free(data);
+}
+
+static void bench_console(void) {
+    int lines = 500000;
+    printf("== console (mini_printf, %d lines of 40 B to a file) ==\n", lines);
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int fd = open("mini_bench_console.tmp", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+    char line[41];
+    memset(line, 'c', 39);
+    line[39] = '\n';
+    line[40] = '\0';
+    double t = now();
+    for (int i = 0; i < lines; i++) {
+        mini_printf(line);
+    }
+    mini_exit_printf();
+    double secs = now() - t;
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    print_rate("  mini_printf", 40.0 * lines, secs);
+    unlink("mini_bench_console.tmp");
+}
+
+static void bench_mem(void) {
+    long size = 256L << 20;
+    printf("== mem (256 MB of log lines, in-memory sink then reader) ==\n");
+    const char* samples[3] = {
+        "2024-11-14 12:00:01 INFO request served in 12 ms path=/index.html\n",
+        "2024-11-14 12:00:02 WARN slow upstream\n",
+        "2024-11-14 12:00:03 DEBUG headers: accept=text/html,application/xhtml+xml user-agent=Mozilla/5.0 (X11; Linux x86_64)\n",
+    };
+    int lengths[3];
+    for (int i = 0; i < 3; i++) {
+        lengths[i] = strlen(samples[i]);
+    }
+
+    // Writers: open_memstream, a file in the page cache, the growable sink
+    char* std_data = NULL;
+    size_t std_len = 0;
+    FILE* std = open_memstream(&std_data, &std_len);
+    long written = 0;
+    double t = now();
+    for (int i = 0; written < size; i++) {
+        written += fwrite(samples[i % 3], 1, lengths[i % 3], std);
+    }
+    fclose(std);
+    print_rate("  open_memstream + fwrite", (double)written, now() - t);
+    free(std_data);
+
+    MYFILE* file = mini_fopen(BENCH_FILE, 'w');
+    written = 0;
+    t = now();
+    for (int i = 0; written < size; i++) {
+        written += mini_fwrite((void*)samples[i % 3], 1, lengths[i % 3], file);
+    }
+    mini_fclose(file);
+    print_rate("  mini_fwrite to a file", (double)written, now() - t);
+
+    MYFILE* sink = mini_fmemopen(NULL, 0, 'w');
+    written = 0;
+    t = now();
+    for (int i = 0; written < size; i++) {
+        written += mini_fwrite((void*)samples[i % 3], 1, lengths[i % 3], sink);
+    }
+    print_rate("  mini_fwrite to mini_fmemopen", (double)written, now() - t);
+
+    // Readers: the same bytes from the file and from the sink, in place
+    int len;
+    long lines = 0;
+    file = mini_fopen(BENCH_FILE, 'r');
+    t = now();
+    while (mini_fgetline(file, &len)) lines++;
+    double elapsed = now() - t;
+    printf("  %-30s %10.1f Mlines/s  %8.1f MB/s\n", "mini_fgetline file", lines / elapsed / 1e6, written / elapsed / 1e6);
+    mini_fclose(file);
+    unlink(BENCH_FILE);
+
+    long view_len;
+    char* view = mini_fmap_view(sink, &view_len);
+    MYFILE* reader = mini_fmemopen(view, view_len, 'r');
+    lines = 0;
+    t = now();
+    while (mini_fgetline(reader, &len)) lines++;
+    elapsed = now() - t;
+    printf("  %-30s %10.1f Mlines/s  %8.1f MB/s\n", "mini_fgetline mini_fmemopen", lines / elapsed / 1e6,
+           written / elapsed / 1e6);
+    mini_fclose(reader);
+    mini_fclose(sink);
+}
+
+static Benchmark benchmarks[] = {
+    {"utf8", bench_utf8},
+    {"fread", bench_fread},
+    {"bulk", bench_bulk},
+    {"vbuf", bench_vbuf},
+    {"mmap", bench_mmap},
+    {"async", bench_async},
+    {"readahead", bench_readahead},
+    {"getline", bench_getline},
+    {"lock", bench_lock},
+    {"registry", bench_registry},
+    {"direct", bench_direct},
+    {"copy", bench_copy},
+    {"lz", bench_lz},
+    {"pool", bench_pool},
+    {"sync", bench_sync},
+    {"mapw", bench_mapw},
+    {"console", bench_console},
+    {"mem", bench_mem},
+};
+
+int main(int argc, char** argv) {
+    int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    for (int i = 0; i < count; i++) {
+        if (argc < 2 || strcmp(argv[1], benchmarks[i].name) == 0) {
+            benchmarks[i].run();
+        }
+    }
+    mini_exit_flush();
+    return 0;
+}
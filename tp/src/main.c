@@ -69,6 +69,12 @@ int main();
 #include <stdlib.h>
 #include <assert.h>
 #include <sys/errno.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <limits.h>
 #include "mini_lib.h"
 
 typedef struct {
@@ -359,6 +365,22 @@ void test_mini_fread() {
     int bytes_read = mini_fread(buffer, 1, 50, file);
     print_test_result(bytes_read > 0, "Test 1 - Read data from file");
     mini_fclose(file);
+
+    // Small records spanning several buffer refills
+    file = mini_fopen("test_records.bin", 'w');
+    for (int i = 0; i < 5000; i++) {
+        mini_fwrite(&i, sizeof(int), 1, file);
+    }
+    mini_fclose(file);
+    file = mini_fopen("test_records.bin", 'r');
+    int passed = 1, value, count = 0;
+    while (mini_fread(&value, sizeof(int), 1, file) == sizeof(int)) {
+        passed = passed && value == count;
+        count++;
+    }
+    print_test_result(passed && count == 5000, "Test 2 - Read small records across refills");
+    mini_fclose(file);
+    unlink("test_records.bin");
 }
 
 void test_mini_fwrite() {
@@ -369,6 +391,25 @@ void test_mini_fwrite() {
     int bytes_written = mini_fwrite(data, 1, strlen(data), file);
     print_test_result(bytes_written == strlen(data), "Test 1 - Write data to file");
     mini_fclose(file);
+
+    // Transfers larger than the stream buffer bypass it in both directions
+    int size = 100000;
+    char* big = malloc(size);
+    char* back = malloc(size);
+    for (int i = 0; i < size; i++) big[i] = (char)(i * 7);
+    file = mini_fopen("test_big.bin", 'w');
+    mini_fwrite("head", 1, 4, file);
+    bytes_written = mini_fwrite(big, 1, size, file);
+    mini_fclose(file);
+    file = mini_fopen("test_big.bin", 'r');
+    int bytes_read = mini_fread(back, 1, 4, file);
+    bytes_read += mini_fread(back, 1, size, file);
+    mini_fclose(file);
+    print_test_result(bytes_written == size && bytes_read == size + 4 && memcmp(big, back, size) == 0,
+                      "Test 2 - Large write and read keep order and content");
+    free(big);
+    free(back);
+    unlink("test_big.bin");
 }
 
 void test_mini_fflush() {
@@ -388,6 +429,1192 @@ void test_mini_fclose() {
     print_test_result(1, "Test 1 - Close file");
 }
 
+void test_mini_setvbuf() {
+    print_test_header("mini_setvbuf");
+
+    // Line buffering: the line reaches the file without mini_fflush
+    char check[16] = {0};
+    MYFILE* file = mini_fopen("test_vbuf.txt", 'w');
+    mini_setvbuf(file, NULL, MINI_IOLBF, 64);
+    mini_fwrite("line\n", 1, 5, file);
+    int fd = open("test_vbuf.txt", O_RDONLY);
+    print_test_result(read(fd, check, sizeof(check)) == 5, "Test 1 - Line buffered flush on newline");
+    close(fd);
+    mini_fclose(file);
+
+    // Caller-provided buffer is used and left alone by mini_fclose
+    char user_buf[32];
+    file = mini_fopen("test_vbuf.txt", 'r');
+    int result = mini_setvbuf(file, user_buf, MINI_IOFBF, sizeof(user_buf));
+    int bytes_read = mini_fread(check, 1, 2, file);
+    print_test_result(result == 0 && bytes_read == 2 && file->buffer_read == user_buf
+                      && memcmp(user_buf, "line\n", 5) == 0, "Test 2 - User supplied buffer");
+    mini_fclose(file);
+
+    // Unbuffered stream writes through immediately
+    file = mini_fopen("test_vbuf.txt", 'a');
+    mini_setvbuf(file, NULL, MINI_IONBF, 0);
+    mini_fwrite("x", 1, 1, file);
+    struct stat info;
+    stat("test_vbuf.txt", &info);
+    print_test_result(info.st_size == 6 && file->buffer_write == NULL, "Test 3 - Unbuffered write");
+    mini_fclose(file);
+    unlink("test_vbuf.txt");
+}
+
+void test_mini_fmap() {
+    print_test_header("mini_fopen 'm'");
+
+    char expected[256];
+    int fd = open("test_read.txt", O_RDONLY);
+    int size = read(fd, expected, sizeof(expected));
+    close(fd);
+
+    MYFILE* file = mini_fopen("test_read.txt", 'm');
+    long len;
+    char* view = mini_fmap_view(file, &len);
+    print_test_result(view != NULL && len == size && memcmp(view, expected, size) == 0,
+                      "Test 1 - Zero-copy view of the mapping");
+    char buffer[256];
+    int first = mini_fread(buffer, 1, 10, file);
+    int rest = mini_fread(buffer + 10, 1, sizeof(buffer) - 10, file);
+    print_test_result(first == 10 && first + rest == size && memcmp(buffer, expected, size) == 0,
+                      "Test 2 - mini_fread from the mapping");
+    mini_fclose(file);
+
+    // Special files cannot be mapped and fall back to buffered reads
+    file = mini_fopen("/dev/null", 'm');
+    print_test_result(file != NULL && mini_fmap_view(file, &len) == NULL && mini_fread(buffer, 1, 1, file) == 0,
+                      "Test 3 - Fallback for special files");
+    mini_fclose(file);
+}
+
+// Writes 8 blocks asynchronously then reads them back with the given backend
+static int run_async_roundtrip(int backend) {
+    if (mini_async_init(16, backend) != backend) {
+        return 0;
+    }
+    MYFILE* file = mini_fopen("test_async.bin", 'b');
+    char blocks[8][512], back[8][512];
+    for (int b = 0; b < 8; b++) {
+        memset(blocks[b], 'A' + b, sizeof(blocks[b]));
+        mini_fwrite_async(file, blocks[b], sizeof(blocks[b]), b * 512L);
+    }
+    int submitted = mini_async_submit();
+    int id, result, ok = submitted == 8;
+    for (int done = 0; done < 8; done++) {
+        ok = ok && mini_async_complete(&id, &result, 1) == 1 && result == 512;
+    }
+    for (int b = 0; b < 8; b++) {
+        mini_fread_async(file, back[b], sizeof(back[b]), b * 512L);
+    }
+    for (int done = 0; done < 8; done++) {
+        ok = ok && mini_async_complete(&id, &result, 1) == 1 && result == 512;
+    }
+    ok = ok && memcmp(blocks, back, sizeof(blocks)) == 0 && mini_async_complete(&id, &result, 0) == 0;
+    mini_fclose(file);
+    unlink("test_async.bin");
+    mini_async_shutdown();
+    return ok;
+}
+
+// Requests at the stream position (offset -1) interleaved with buffered I/O
+static int run_async_position(int backend) {
+    if (mini_async_init(16, backend) != backend) {
+        return 0;
+    }
+    char text[] = "header|", block[3][256], tail[] = "|tail";
+    MYFILE* file = mini_fopen("test_async.bin", 'b');
+    mini_fwrite(text, 1, 7, file);              // still in the stream buffer
+    for (int b = 0; b < 3; b++) {
+        memset(block[b], 'a' + b, sizeof(block[b]));
+        mini_fwrite_async(file, block[b], sizeof(block[b]), -1);
+    }
+    long after = mini_ftell(file);
+    mini_fwrite(tail, 1, 5, file);
+    int id, result, ok = mini_async_submit() == 3;
+    for (int done = 0; done < 3; done++) {
+        ok = ok && mini_async_complete(&id, &result, 1) == 1 && result == 256;
+    }
+    mini_fclose(file);
+    ok = ok && after == 7 + 3 * 256;
+
+    // Read side: the bytes already buffered by mini_fread are not skipped
+    char head[7], middle[256], rest[5];
+    file = mini_fopen("test_async.bin", 'r');
+    mini_fread(head, 1, 7, file);
+    mini_fread_async(file, middle, sizeof(middle), -1);
+    ok = ok && mini_async_complete(&id, &result, 1) == 1 && result == 256;
+    mini_fseek(file, 2 * 256, SEEK_CUR);
+    ok = ok && mini_fread(rest, 1, 5, file) == 5;
+    mini_fclose(file);
+    unlink("test_async.bin");
+    mini_async_shutdown();
+    return ok && memcmp(head, text, 7) == 0 && memcmp(middle, block[0], 256) == 0 && memcmp(rest, tail, 5) == 0;
+}
+
+void test_mini_async() {
+    print_test_header("mini_async");
+
+    print_test_result(run_async_roundtrip(MINI_AIO_THREADS), "Test 1 - Thread pool backend");
+    print_test_result(run_async_position(MINI_AIO_THREADS), "Test 2 - Thread pool at the stream position");
+    // io_uring may be disabled (old kernel, seccomp): only the fallback is mandatory
+    if (mini_async_init(16, MINI_AIO_URING) == MINI_AIO_URING) {
+        mini_async_shutdown();
+        print_test_result(run_async_roundtrip(MINI_AIO_URING), "Test 3 - io_uring backend");
+        print_test_result(run_async_position(MINI_AIO_URING), "Test 4 - io_uring at the stream position");
+    }
+}
+
+void test_mini_iov() {
+    print_test_header("mini_fwritev / mini_freadv");
+
+    // Small record coalesced in the buffer, then a large one through writev
+    char header[] = "HDR:", newline[] = "\n";
+    char* payload = malloc(10000);
+    memset(payload, 'p', 10000);
+    struct iovec small[3] = {{header, 4}, {payload, 10}, {newline, 1}};
+    struct iovec large[3] = {{header, 4}, {payload, 10000}, {newline, 1}};
+    MYFILE* file = mini_fopen("test_iov.txt", 'w');
+    int small_written = mini_fwritev(file, small, 3);
+    int buffered = file->ind_write;
+    int large_written = mini_fwritev(file, large, 3);
+    mini_fclose(file);
+    print_test_result(small_written == 15 && buffered == 15 && large_written == 10005,
+                      "Test 1 - Small record buffered, large record written");
+
+    char head[15], tail[5];
+    char* body = malloc(10000);
+    struct iovec parts[3] = {{head, 15}, {body, 10000}, {tail, 5}};
+    file = mini_fopen("test_iov.txt", 'r');
+    int bytes_read = mini_freadv(file, parts, 3);
+    mini_fclose(file);
+    print_test_result(bytes_read == 10020 && memcmp(head, "HDR:pppppppppp\n", 15) == 0
+                      && memcmp(body, "HDR:p", 5) == 0 && memcmp(tail, "pppp\n", 5) == 0,
+                      "Test 2 - Scatter read keeps order");
+    free(payload);
+    free(body);
+    unlink("test_iov.txt");
+}
+
+void test_mini_fseek() {
+    print_test_header("mini_fseek / mini_ftell");
+
+    MYFILE* file = mini_fopen("test_seek.bin", 'w');
+    for (int i = 0; i < 5000; i++) {
+        mini_fwrite(&i, sizeof(int), 1, file);
+    }
+    print_test_result(mini_ftell(file) == 20000, "Test 1 - ftell counts buffered writes");
+    mini_fclose(file);
+
+    int value = -1;
+    file = mini_fopen("test_seek.bin", 'b');
+    mini_fread(&value, sizeof(int), 1, file);
+    long fd_offset = file->offset;
+    mini_fseek(file, 100 * sizeof(int), SEEK_SET);
+    mini_fread(&value, sizeof(int), 1, file);
+    print_test_result(value == 100 && file->offset == fd_offset && mini_ftell(file) == 101 * sizeof(int),
+                      "Test 2 - Seek inside the read buffer without a syscall");
+
+    mini_fseek(file, -(long)sizeof(int), SEEK_END);
+    mini_fread(&value, sizeof(int), 1, file);
+    print_test_result(value == 4999 && mini_ftell(file) == 20000, "Test 3 - Seek from the end");
+
+    int patched = 424242, check = 0, pos_before = mini_ftell(file);
+    mini_fpwrite(file, &patched, sizeof(int), 7 * sizeof(int));
+    mini_fpread(file, &check, sizeof(int), 7 * sizeof(int));
+    print_test_result(check == patched && mini_ftell(file) == pos_before, "Test 4 - pread/pwrite keep the position");
+    mini_fclose(file);
+
+    // 'b': a write after a seek inside the read buffer lands at the logical
+    // position, and a read after a write sees the written bytes in place
+    int fd = open("test_seek.bin", O_WRONLY | O_TRUNC);
+    write(fd, "0123456789abcdefghij", 20);
+    close(fd);
+    file = mini_fopen("test_seek.bin", 'b');
+    char head[4], next[2];
+    mini_fread(head, 1, 4, file);
+    mini_fseek(file, 2, SEEK_SET);
+    mini_fwrite("XY", 1, 2, file);
+    long after_write = mini_ftell(file);
+    int got_next = mini_fread(next, 1, 2, file);
+    long after_read = mini_ftell(file);
+    mini_fclose(file);
+    char back[32] = {0};
+    fd = open("test_seek.bin", O_RDONLY);
+    int size = read(fd, back, sizeof(back));
+    close(fd);
+    print_test_result(size == 20 && memcmp(back, "01XY456789abcdefghij", 20) == 0 && after_write == 4
+                      && got_next == 2 && memcmp(next, "45", 2) == 0 && after_read == 6,
+                      "Test 5 - Read, seek and write on a 'b' stream");
+
+    // 'm': a seek past the end of the mapping reads nothing and stays put
+    file = mini_fopen("test_seek.bin", 'm');
+    int seek_past = mini_fseek(file, 100, SEEK_END);
+    int got_past = mini_fread(back, 1, sizeof(back), file);
+    int pread_past = mini_fpread(file, back, sizeof(back), 500);
+    int line_len;
+    char* line_past = mini_fgetline(file, &line_len);
+    long tell_past = mini_ftell(file);
+    mini_fclose(file);
+    print_test_result(seek_past == 0 && got_past == 0 && pread_past == 0 && line_past == NULL && tell_past == 120,
+                      "Test 6 - Mapped reads past the end");
+    unlink("test_seek.bin");
+}
+
+void test_mini_freadahead() {
+    print_test_header("mini_freadahead");
+
+    // Several read-ahead blocks of increasing integers
+    int count = 400000;
+    MYFILE* file = mini_fopen("test_readahead.bin", 'w');
+    for (int i = 0; i < count; i++) {
+        mini_fwrite(&i, sizeof(int), 1, file);
+    }
+    mini_fclose(file);
+
+    file = mini_fopen("test_readahead.bin", 'r');
+    int enabled = mini_freadahead(file, 1);
+    int value, ok = 1, n = 0;
+    while (mini_fread(&value, sizeof(int), 1, file) == sizeof(int)) {
+        ok = ok && value == n;
+        n++;
+    }
+    print_test_result(enabled == 0 && ok && n == count, "Test 1 - Sequential read through both buffers");
+
+    mini_fseek(file, 123456L * sizeof(int), SEEK_SET);
+    mini_fread(&value, sizeof(int), 1, file);
+    print_test_result(value == 123456 && mini_ftell(file) == 123457L * sizeof(int), "Test 2 - Seek restarts the reader");
+
+    // Disabling hands the stream back at the same position
+    mini_freadahead(file, 0);
+    mini_fread(&value, sizeof(int), 1, file);
+    print_test_result(value == 123457 && file->readahead == NULL, "Test 3 - Disable keeps the position");
+    mini_fclose(file);
+
+    file = mini_fopen("test_readahead.bin", 'w');
+    print_test_result(mini_freadahead(file, 1) == -1 && errno == EINVAL, "Test 4 - Refused on a write stream");
+    mini_fclose(file);
+    unlink("test_readahead.bin");
+}
+
+void test_mini_fgetline() {
+    print_test_header("mini_fgetline");
+
+    // Short lines, one line longer than the 64-byte buffer, no final newline
+    char long_line[301];
+    memset(long_line, 'L', 299);
+    long_line[299] = '\n';
+    long_line[300] = '\0';
+    MYFILE* file = mini_fopen("test_lines.txt", 'w');
+    mini_fwrite("first\nsecond\n", 1, 13, file);
+    mini_fwrite(long_line, 1, 300, file);
+    mini_fwrite("last", 1, 4, file);
+    mini_fclose(file);
+
+    file = mini_fopen("test_lines.txt", 'r');
+    mini_setvbuf(file, NULL, MINI_IOFBF, 64);
+    int len;
+    char* line = mini_fgetline(file, &len);
+    print_test_result(len == 6 && memcmp(line, "first\n", 6) == 0
+                      && line >= (char*)file->buffer_read && line < (char*)file->buffer_read + 64,
+                      "Test 1 - Line returned in place");
+    line = mini_fgetline(file, &len);
+    print_test_result(len == 7 && memcmp(line, "second\n", 7) == 0, "Test 2 - Next line");
+    line = mini_fgetline(file, &len);
+    print_test_result(len == 300 && memcmp(line, long_line, 300) == 0, "Test 3 - Line longer than the buffer");
+    line = mini_fgetline(file, &len);
+    print_test_result(len == 4 && memcmp(line, "last", 4) == 0, "Test 4 - Last line without newline");
+    print_test_result(mini_fgetline(file, &len) == NULL && len == 0, "Test 5 - NULL at end of file");
+    mini_fclose(file);
+
+    // Same lines straight from the mapping
+    file = mini_fopen("test_lines.txt", 'm');
+    int count = 0;
+    while (mini_fgetline(file, &len)) {
+        count++;
+    }
+    print_test_result(count == 4, "Test 6 - Lines of a mapped file");
+    mini_fclose(file);
+    unlink("test_lines.txt");
+}
+
+#define LOCK_THREADS 4
+#define LOCK_RECORDS 5000
+
+// Appends fixed 8-byte records "t<id>:<seq>\n" to the shared stream
+static void* write_records(void* arg) {
+    MYFILE* file = ((MYFILE**)arg)[0];
+    int id = (int)(long)((MYFILE**)arg)[1];
+    char record[8];
+    for (int i = 0; i < LOCK_RECORDS; i++) {
+        record[0] = 't';
+        record[1] = '0' + id;
+        record[2] = ':';
+        for (int d = 0, v = i; d < 4; d++, v /= 10) {
+            record[6 - d] = '0' + v % 10;
+        }
+        record[7] = '\n';
+        mini_fwrite(record, 1, sizeof(record), file);
+    }
+    return NULL;
+}
+
+static void* try_lock(void* arg) {
+    int result = mini_ftrylockfile((MYFILE*)arg);
+    if (result == 0) {
+        mini_funlockfile((MYFILE*)arg);
+    }
+    return (void*)(long)result;
+}
+
+void test_mini_flockfile() {
+    print_test_header("mini_flockfile");
+
+    // Concurrent writers on one stream: every record must arrive whole
+    MYFILE* file = mini_fopen("test_lock.txt", 'w');
+    mini_setvbuf(file, NULL, MINI_IOFBF, 100); // Records straddle buffer flushes
+    pthread_t threads[LOCK_THREADS];
+    void* args[LOCK_THREADS][2];
+    for (int t = 0; t < LOCK_THREADS; t++) {
+        args[t][0] = file;
+        args[t][1] = (void*)(long)t;
+        pthread_create(&threads[t], NULL, write_records, args[t]);
+    }
+    for (int t = 0; t < LOCK_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    mini_fclose(file);
+
+    file = mini_fopen("test_lock.txt", 'r');
+    int next[LOCK_THREADS] = {0}, ok = 1, len;
+    char* line;
+    while ((line = mini_fgetline(file, &len))) {
+        int id = line[1] - '0';
+        ok = ok && len == 8 && id >= 0 && id < LOCK_THREADS && atoi(line + 3) == next[id];
+        if (ok) {
+            next[id]++;
+        }
+    }
+    mini_fclose(file);
+    for (int t = 0; t < LOCK_THREADS; t++) {
+        ok = ok && next[t] == LOCK_RECORDS;
+    }
+    print_test_result(ok, "Test 1 - Concurrent writers keep records whole and ordered");
+
+    // Recursive ownership, and another thread cannot take the lock meanwhile
+    file = mini_fopen("test_lock.txt", 'r');
+    mini_flockfile(file);
+    mini_flockfile(file);
+    char buffer[8];
+    int bytes_read = mini_fread_unlocked(buffer, 1, sizeof(buffer), file);
+    pthread_t other;
+    void* other_result;
+    pthread_create(&other, NULL, try_lock, file);
+    pthread_join(other, &other_result);
+    mini_funlockfile(file);
+    mini_funlockfile(file);
+    pthread_create(&other, NULL, try_lock, file);
+    void* after_result;
+    pthread_join(other, &after_result);
+    print_test_result(bytes_read == 8 && (long)other_result == -1 && (long)after_result == 0,
+                      "Test 2 - Recursive lock excludes other threads");
+    mini_fclose(file);
+    unlink("test_lock.txt");
+}
+
+void test_mini_open_files() {
+    print_test_header("open file registry");
+
+    // Enough streams to grow the descriptor table several times
+    MYFILE* streams[300];
+    int opened = 0;
+    for (int i = 0; i < 300; i++) {
+        streams[i] = mini_fopen("test.txt", 'r');
+        opened += streams[i] != NULL;
+    }
+    int closed = 0;
+    for (int i = 0; i < 300; i++) {
+        closed += mini_fclose(streams[i]) == 0;
+    }
+    print_test_result(opened == 300 && closed == 300, "Test 1 - Open and close 300 streams");
+
+    // Only the stream with pending data is written by the exit flush
+    MYFILE* pending = mini_fopen("test_dirty.txt", 'w');
+    MYFILE* idle = mini_fopen("test_idle.txt", 'w');
+    mini_fwrite("pending", 1, 7, pending);
+    mini_fwrite("flushed", 1, 7, idle);
+    mini_fflush(idle);
+    mini_exit_flush();
+    struct stat info;
+    stat("test_dirty.txt", &info);
+    print_test_result(info.st_size == 7 && pending->ind_write == 0 && pending->dirty == 0 && idle->dirty == 0,
+                      "Test 2 - Exit flush empties the dirty streams");
+    mini_fclose(pending);
+    mini_fclose(idle);
+
+    // Writes that exactly fill the buffer leave nothing pending: the stream
+    // must leave the dirty list, or the exit flush would never end
+    MYFILE* exact = mini_fopen("test_dirty.txt", 'w');
+    char* block = calloc(exact->buffer_size, 1);
+    mini_fwrite(block, 1, 1, exact);
+    mini_fwrite(block, 1, exact->buffer_size - 1, exact);
+    int clean_after_fill = exact->dirty == 0;
+    for (int i = 0; i < 2 * exact->buffer_size / 4; i++) {
+        mini_fwrite("abc\n", 1, 4, exact);
+    }
+    int clean_after_lines = exact->dirty == 0;
+    mini_exit_flush();
+    stat("test_dirty.txt", &info);
+    print_test_result(clean_after_fill && clean_after_lines && info.st_size == 3L * exact->buffer_size,
+                      "Test 3 - Buffer-sized writes leave the dirty list");
+    mini_fclose(exact);
+    free(block);
+    unlink("test_dirty.txt");
+    unlink("test_idle.txt");
+}
+
+void test_mini_direct() {
+    print_test_header("mini_fopen 'd' / 'D' (O_DIRECT)");
+
+    // Unaligned size, a flush in the middle leaves an unaligned tail
+    int size = 3 * 4096 * 300 + 123;
+    char* data = malloc(size);
+    for (int i = 0; i < size; i++) {
+        data[i] = 'a' + (i * 7 + i / 4096) % 26;
+    }
+    MYFILE* file = mini_fopen("test_direct.bin", 'D');
+    int ok = file != NULL;
+    for (int done = 0; ok && done < size; done += 1000) {
+        int n = size - done < 1000 ? size - done : 1000;
+        ok = mini_fwrite(data + done, 1, n, file) == n;
+        if (done == 5000) {
+            ok = ok && mini_fflush(file) >= 0 && mini_ftell(file) == 6000;
+        }
+    }
+    int closed = mini_fclose(file);
+    char* back = malloc(size);
+    int fd = open("test_direct.bin", O_RDONLY);
+    int got = read(fd, back, size);
+    close(fd);
+    print_test_result(ok && closed == 0 && got == size && memcmp(back, data, size) == 0,
+                      "Test 1 - Direct write with unaligned flush and tail");
+
+    file = mini_fopen("test_direct.bin", 'd');
+    memset(back, 0, size);
+    int total = 0, n;
+    while ((n = mini_fread(back + total, 1, 777, file)) > 0) {
+        total += n;
+    }
+    print_test_result(total == size && memcmp(back, data, size) == 0, "Test 2 - Direct read up to the unaligned tail");
+
+    char piece[10];
+    mini_fseek(file, 123457, SEEK_SET);
+    mini_fread(piece, 1, sizeof(piece), file);
+    int seek_ok = memcmp(piece, data + 123457, sizeof(piece)) == 0 && mini_ftell(file) == 123467;
+    mini_fpread(file, piece, sizeof(piece), 99);
+    print_test_result(seek_ok && memcmp(piece, data + 99, sizeof(piece)) == 0,
+                      "Test 3 - Unaligned seek and pread");
+    mini_fclose(file);
+    free(data);
+    free(back);
+    unlink("test_direct.bin");
+}
+
+void test_mini_fcopy() {
+    print_test_header("mini_fcopy");
+
+    int size = 200000;
+    char* data = malloc(size);
+    for (int i = 0; i < size; i++) {
+        data[i] = 'a' + i % 23;
+    }
+    int fd = open("test_copy_src.bin", O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    write(fd, data, size);
+    close(fd);
+
+    // Pending bytes on both sides: the source buffer and the destination buffer
+    MYFILE* src = mini_fopen("test_copy_src.bin", 'r');
+    MYFILE* dst = mini_fopen("test_copy_dst.bin", 'w');
+    char head[10];
+    mini_fread(head, 1, sizeof(head), src);
+    mini_fwrite("HDR", 1, 3, dst);
+    long copied = mini_fcopy(dst, src, -1);
+    long src_pos = mini_ftell(src), dst_pos = mini_ftell(dst);
+    mini_fclose(src);
+    mini_fclose(dst);
+    char* back = malloc(size + 3);
+    fd = open("test_copy_dst.bin", O_RDONLY);
+    int got = read(fd, back, size + 3);
+    close(fd);
+    print_test_result(copied == size - 10 && got == size - 7 && memcmp(back, "HDR", 3) == 0
+                      && memcmp(back + 3, data + 10, size - 10) == 0 && src_pos == size && dst_pos == size - 7,
+                      "Test 1 - Copy to end of file after buffered reads and writes");
+
+    // Bounded copy from a character device into an append-only stream
+    dst = mini_fopen("test_copy_dst.bin", 'a');
+    src = mini_fopen("/dev/zero", 'r');
+    copied = mini_fcopy(dst, src, 5000);
+    mini_fclose(src);
+    mini_fclose(dst);
+    struct stat info;
+    stat("test_copy_dst.bin", &info);
+    print_test_result(copied == 5000 && info.st_size == size - 7 + 5000, "Test 2 - Bounded copy into append mode");
+
+    // Mapped source keeps its own position
+    src = mini_fopen("test_copy_src.bin", 'm');
+    dst = mini_fopen("test_copy_dst.bin", 'w');
+    mini_fseek(src, 100, SEEK_SET);
+    copied = mini_fcopy(dst, src, 1000);
+    mini_fclose(dst);
+    fd = open("test_copy_dst.bin", O_RDONLY);
+    got = read(fd, back, size);
+    close(fd);
+    print_test_result(copied == 1000 && got == 1000 && memcmp(back, data + 100, 1000) == 0 && mini_ftell(src) == 1100,
+                      "Test 3 - Copy from a mapped stream");
+    mini_fclose(src);
+
+    // A 'b' source writes its pending bytes before the copy reads after them
+    src = mini_fopen("test_copy_src.bin", 'b');
+    dst = mini_fopen("test_copy_dst.bin", 'w');
+    mini_fwrite("XYZ", 1, 3, src);
+    copied = mini_fcopy(dst, src, 10);
+    mini_fclose(dst);
+    mini_fclose(src);
+    fd = open("test_copy_dst.bin", O_RDONLY);
+    got = read(fd, back, size);
+    close(fd);
+    char patched[3];
+    fd = open("test_copy_src.bin", O_RDONLY);
+    read(fd, patched, 3);
+    close(fd);
+    print_test_result(copied == 10 && got == 10 && memcmp(back, data + 3, 10) == 0 && memcmp(patched, "XYZ", 3) == 0,
+                      "Test 4 - Pending writes of the source are flushed first");
+
+    // Read-ahead enabled by the caller survives the copy
+    src = mini_fopen("test_copy_src.bin", 'r');
+    dst = mini_fopen("test_copy_dst.bin", 'w');
+    mini_freadahead(src, 1);
+    mini_fread(head, 1, sizeof(head), src);
+    copied = mini_fcopy(dst, src, 100000);
+    int still_enabled = src->readahead != NULL;
+    got = mini_fread(back, 1, 1000, src);
+    mini_fclose(dst);
+    mini_fclose(src);
+    print_test_result(copied == 100000 && still_enabled && got == 1000 && memcmp(back, data + 100010, 1000) == 0,
+                      "Test 5 - Read-ahead is restored after the copy");
+
+    // Pipe source into an append-only stream: splice cannot write to
+    // O_APPEND, the bytes already taken from the pipe must not be lost
+    int pipe_fds[2];
+    pipe(pipe_fds);
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        close(pipe_fds[0]);
+        for (int done = 0; done < size;) {
+            int n = write(pipe_fds[1], data + done, size - done);
+            if (n <= 0) _exit(1);
+            done += n;
+        }
+        _exit(0);
+    }
+    close(pipe_fds[1]);
+    unlink("test_copy_dst.bin");
+    char pipe_path[32];
+    snprintf(pipe_path, sizeof(pipe_path), "/dev/fd/%d", pipe_fds[0]);
+    src = mini_fopen(pipe_path, 'r');
+    dst = mini_fopen("test_copy_dst.bin", 'a');
+    copied = mini_fcopy(dst, src, -1);
+    mini_fclose(dst);
+    mini_fclose(src);
+    close(pipe_fds[0]);
+    waitpid(child, NULL, 0);
+    fd = open("test_copy_dst.bin", O_RDONLY);
+    got = read(fd, back, size);
+    close(fd);
+    print_test_result(copied == size && got == size && memcmp(back, data, size) == 0,
+                      "Test 6 - Copy from a pipe into append mode");
+    free(data);
+    free(back);
+    unlink("test_copy_src.bin");
+    unlink("test_copy_dst.bin");
+}
+
+void test_mini_lz() {
+    print_test_header("mini_lz");
+
+    // Log-like lines followed by random bytes the writer must store as is
+    int size = 300000;
+    char* data = malloc(size);
+    unsigned int seed = 12345;
+    for (int i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        if (i >= 200000) {
+            data[i] = (char)(seed >> 16);
+        } else if (i % 64 == 63) {
+            data[i] = '\n';
+        } else {
+            data[i] = i % 64 < 40 ? "GET /index.html HTTP/1.1 200 "[i % 29] : (char)('a' + (seed >> 16) % 26);
+        }
+    }
+    int bound = mini_lz_bound(200000);
+    char* packed = malloc(bound);
+    char* back = malloc(size);
+    int packed_len = mini_lz_compress(data, 200000, packed, bound);
+    int raw_len = mini_lz_decompress(packed, packed_len, back, size);
+    print_test_result(packed_len > 0 && packed_len < 200000 && raw_len == 200000 && memcmp(back, data, 200000) == 0,
+                      "Test 1 - Raw compress and decompress round trip");
+
+    // A short block from a mid-stream flush, then full blocks
+    MYFILE* file = mini_fopen("test_lz.bin", 'Z');
+    int written = mini_fwrite(data, 1, 1000, file);
+    int flushed = mini_fflush(file);
+    written += mini_fwrite(data + 1000, 1, size - 1000, file);
+    int closed = mini_fclose(file);
+    struct stat info;
+    stat("test_lz.bin", &info);
+    file = mini_fopen("test_lz.bin", 'z');
+    int got = 0, n;
+    while (got < size && (n = mini_fread(back + got, 1, size - got < 7000 ? size - got : 7000, file)) > 0) {
+        got += n;
+    }
+    print_test_result(written == size && flushed == 1000 && closed == 0 && info.st_size < size && got == size
+                      && memcmp(back, data, size) == 0,
+                      "Test 2 - Write with 'Z' and read back with 'z'");
+
+    char piece[50];
+    int seek_ok = mini_fseek(file, 123457, SEEK_SET) == 0;
+    print_test_result(seek_ok && mini_fread(piece, 1, sizeof(piece), file) == sizeof(piece)
+                      && memcmp(piece, data + 123457, sizeof(piece)) == 0 && mini_ftell(file) == 123507,
+                      "Test 3 - Seek inside a compressed stream");
+    // SEEK_END is relative to the decompressed length, not the file size
+    int end_ok = mini_fseek(file, -10, SEEK_END) == 0;
+    long end_tell = mini_ftell(file);
+    print_test_result(end_ok && end_tell == size - 10 && mini_fread(piece, 1, sizeof(piece), file) == 10
+                      && memcmp(piece, data + size - 10, 10) == 0,
+                      "Test 4 - Seek from the end of a compressed stream");
+
+    // Block 0 holds the flushed 1000 bytes, the last blocks are stored as is
+    int blocks = mini_fzblocks(file);
+    int block_len = mini_fzread_block(file, 1, back, size);
+    int last_len = mini_fzread_block(file, blocks - 1, back + block_len, size - block_len);
+    print_test_result(blocks == 6 && block_len == 65536 && memcmp(back, data + 1000, block_len) == 0
+                      && last_len == (size - 1000) % 65536
+                      && memcmp(back + block_len, data + size - last_len, last_len) == 0
+                      && mini_fzread_block(file, blocks, back, size) == -1,
+                      "Test 5 - Independent block reads");
+    mini_fclose(file);
+
+    int fd = open("test_lz.bin", O_WRONLY | O_TRUNC);
+    write(fd, data, 100);
+    close(fd);
+    print_test_result(mini_fopen("test_lz.bin", 'z') == NULL && errno == EINVAL, "Test 6 - Reject a plain file");
+    free(data);
+    free(packed);
+    free(back);
+    unlink("test_lz.bin");
+}
+
+static void* pool_cycles(void* arg) {
+    int id = (int)(long)arg;
+    char name[32] = "test_pool_0.txt";
+    name[10] = '0' + id;
+    char data[3000], back[3000];
+    long errors = 0;
+    for (int round = 0; round < 200; round++) {
+        int len = 100 + (round * 37 + id * 11) % 2900;
+        for (int i = 0; i < len; i++) {
+            data[i] = 'a' + (i + round + id) % 26;
+        }
+        MYFILE* file = mini_fopen(name, 'w');
+        mini_fwrite(data, 1, len, file);
+        mini_fclose(file);
+        file = mini_fopen(name, 'r');
+        int got = mini_fread(back, 1, sizeof(back), file);
+        mini_fclose(file);
+        errors += got != len || memcmp(back, data, len) != 0;
+    }
+    unlink(name);
+    return (void*)errors;
+}
+
+void test_mini_buffer_pool() {
+    print_test_header("stream buffer pool");
+
+    // A recycled buffer still holds the previous stream's bytes, which must stay hidden
+    MYFILE* file = mini_fopen("test_pool.txt", 'w');
+    mini_fwrite("0123456789", 1, 10, file);
+    mini_fclose(file);
+    file = mini_fopen("test_pool.txt", 'w');
+    mini_fwrite("abc", 1, 3, file);
+    mini_fclose(file);
+    file = mini_fopen("test_pool.txt", 'r');
+    char back[16];
+    int got = mini_fread(back, 1, sizeof(back), file);
+    int aligned = ((long)file->buffer_read & 4095) == 0;
+    mini_fclose(file);
+    print_test_result(got == 3 && memcmp(back, "abc", 3) == 0, "Test 1 - Recycled buffers only expose new data");
+    print_test_result(aligned, "Test 2 - Buffers are page aligned");
+
+    // Buffers move between thread caches and the shared pool
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, pool_cycles, (void*)(long)i);
+    }
+    long errors = 0;
+    for (int i = 0; i < 4; i++) {
+        void* result;
+        pthread_join(threads[i], &result);
+        errors += (long)result;
+    }
+    print_test_result(errors == 0, "Test 3 - Open, write, read and close from 4 threads");
+    unlink("test_pool.txt");
+}
+
+void test_mini_fstats() {
+    print_test_header("mini_fstats");
+
+    char data[10000];
+    memset(data, 's', sizeof(data));
+    int fd = open("test_stats.txt", O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    write(fd, data, sizeof(data));
+    close(fd);
+
+    // One refill serves the next small reads
+    MYFILE* file = mini_fopen("test_stats.txt", 'r');
+    mini_setvbuf(file, NULL, MINI_IOFBF, 4096);
+    char back[100];
+    for (int i = 0; i < 10; i++) {
+        mini_fread(back, 1, sizeof(back), file);
+    }
+    mini_iostats stats;
+    mini_fstats(file, &stats);
+    print_test_result(stats.read_calls == 1 && stats.bytes_read == 4096 && stats.read_requests == 10
+                      && stats.read_hits == 9 && stats.short_reads == 0,
+                      "Test 1 - Read calls and buffer hits");
+    while (mini_fread(back, 1, sizeof(back), file) > 0) {
+    }
+    mini_fstats(file, &stats);
+    long counted = 0;
+    for (int i = 0; i < MINI_STATS_BUCKETS; i++) {
+        counted += stats.read_latency[i];
+    }
+    print_test_result(stats.bytes_read == 10000 && stats.read_calls == 4 && stats.short_reads == 2
+                      && counted == stats.read_calls,
+                      "Test 2 - Short reads at end of file and latency histogram");
+    mini_fclose(file);
+
+    file = mini_fopen("test_stats.txt", 'w');
+    for (int i = 0; i < 5; i++) {
+        mini_fwrite("0123456789", 1, 10, file);
+    }
+    mini_fflush(file);
+    mini_fflush(file);
+    mini_fstats(file, &stats);
+    print_test_result(stats.write_requests == 5 && stats.write_hits == 5 && stats.write_calls == 1
+                      && stats.bytes_written == 50 && stats.flushes == 1,
+                      "Test 3 - Buffered writes and flushes");
+    mini_fclose(file);
+
+    // Report written to the error output by the exit flush
+    int saved = dup(STDERR_FILENO);
+    fd = open("test_stats.txt", O_WRONLY | O_TRUNC);
+    dup2(fd, STDERR_FILENO);
+    mini_fstats_report(1);
+    mini_exit_flush();
+    mini_fstats_report(0);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+    close(fd);
+    char report[512] = {0};
+    fd = open("test_stats.txt", O_RDONLY);
+    read(fd, report, sizeof(report) - 1);
+    close(fd);
+    print_test_result(strstr(report, "mini_io stats") != NULL && strstr(report, "read latency") != NULL
+                      && mini_fstats(NULL, &stats) == -1,
+                      "Test 4 - Exit report");
+    unlink("test_stats.txt");
+}
+
+#define SYNC_RECORDS 50
+
+static void* flush_records(void* arg) {
+    MYFILE* file = (MYFILE*)arg;
+    long errors = 0;
+    for (int i = 0; i < SYNC_RECORDS; i++) {
+        mini_fwrite("record\n", 1, 7, file);
+        errors += mini_fflush(file) == -1;
+    }
+    return (void*)errors;
+}
+
+void test_mini_fsetsync() {
+    print_test_header("mini_fsetsync");
+
+    MYFILE* file = mini_fopen("test_sync.txt", 'w');
+    int invalid = mini_fsetsync(file, 7, 0) == -1 && errno == EINVAL;
+    mini_fsetsync(file, MINI_SYNC_FLUSH, 0);
+    for (int i = 0; i < 5; i++) {
+        mini_fwrite("record\n", 1, 7, file);
+        mini_fflush(file);
+    }
+    mini_fflush(file); // Nothing written since the last sync
+    mini_iostats stats;
+    mini_fstats(file, &stats);
+    print_test_result(invalid && stats.syncs == 5, "Test 1 - One fdatasync per flush");
+    mini_fclose(file);
+
+    // Long interval: nothing synced before close, which syncs the rest
+    file = mini_fopen("test_sync.txt", 'w');
+    mini_fsetsync(file, MINI_SYNC_PERIODIC, 60 * 1000000);
+    for (int i = 0; i < 5; i++) {
+        mini_fwrite("record\n", 1, 7, file);
+        mini_fflush(file);
+    }
+    mini_fstats(file, &stats);
+    long before_close = stats.syncs;
+    mini_fclose(file);
+    struct stat info;
+    stat("test_sync.txt", &info);
+    print_test_result(before_close == 0 && info.st_size == 35, "Test 2 - Periodic sync waits for the interval");
+
+    // Concurrent flushes share fdatasync calls within the window
+    file = mini_fopen("test_sync.txt", 'w');
+    mini_fsetsync(file, MINI_SYNC_GROUP, 2000);
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, flush_records, file);
+    }
+    long errors = 0;
+    for (int i = 0; i < 4; i++) {
+        void* result;
+        pthread_join(threads[i], &result);
+        errors += (long)result;
+    }
+    mini_fstats(file, &stats);
+    mini_fclose(file);
+    stat("test_sync.txt", &info);
+    print_test_result(errors == 0 && stats.syncs > 0 && stats.syncs < 4 * SYNC_RECORDS
+                      && info.st_size == 4 * SYNC_RECORDS * 7,
+                      "Test 3 - Group commit");
+
+    // Bytes copied by the kernel (mini_fcopy) are synced like written ones
+    char* payload = calloc(100000, 1);
+    int fd = open("test_sync_src.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    write(fd, payload, 100000);
+    close(fd);
+    free(payload);
+    MYFILE* src = mini_fopen("test_sync_src.txt", 'r');
+    file = mini_fopen("test_sync.txt", 'w');
+    mini_fsetsync(file, MINI_SYNC_FLUSH, 0);
+    long copied = mini_fcopy(file, src, -1);
+    mini_fflush(file);
+    mini_fstats(file, &stats);
+    mini_fclose(file);
+    mini_fclose(src);
+    unlink("test_sync_src.txt");
+    print_test_result(copied == 100000 && stats.syncs == 1, "Test 4 - Kernel copies are synced");
+    unlink("test_sync.txt");
+}
+
+void test_mini_mapw() {
+    print_test_header("mini_fopen 'M' (mapped write)");
+
+    int size = 100000;
+    char* data = malloc(size);
+    for (int i = 0; i < size; i++) {
+        data[i] = 'a' + (i * 3 + i / 1000) % 26;
+    }
+    // The file is grown in large extents, kept by flush and trimmed at close
+    MYFILE* file = mini_fopen("test_mapw.bin", 'M');
+    int written = 0;
+    for (int i = 0; i < 40000; i += 1000) {
+        written += mini_fwrite(data + i, 1, 1000, file);
+    }
+    mini_fflush(file);
+    struct stat info;
+    stat("test_mapw.bin", &info);
+    long flushed_size = info.st_size;
+    written += mini_fwrite(data + 40000, 1, size - 40000, file);
+    int closed = mini_fclose(file);
+    char* back = malloc(size + 1);
+    int fd = open("test_mapw.bin", O_RDONLY);
+    int got = read(fd, back, size + 1);
+    close(fd);
+    print_test_result(written == size && flushed_size > 40000 && closed == 0 && got == size
+                      && memcmp(back, data, size) == 0,
+                      "Test 1 - Flush keeps the extent, close trims to the written length");
+
+    // Overwrite in place, then leave a hole past the end
+    file = mini_fopen("test_mapw.bin", 'M');
+    mini_fwrite(data, 1, 100, file);
+    mini_fseek(file, 10, SEEK_SET);
+    mini_fwrite("XYZ", 1, 3, file);
+    mini_fseek(file, 50, SEEK_END);
+    long tell = mini_ftell(file);
+    mini_fwrite("end", 1, 3, file);
+    mini_fclose(file);
+    fd = open("test_mapw.bin", O_RDONLY);
+    got = read(fd, back, size);
+    close(fd);
+    char zeros[50] = {0};
+    print_test_result(tell == 150 && got == 153 && memcmp(back, data, 10) == 0 && memcmp(back + 10, "XYZ", 3) == 0
+                      && memcmp(back + 100, zeros, 50) == 0 && memcmp(back + 150, "end", 3) == 0,
+                      "Test 2 - Seek, overwrite and hole");
+
+    // A record straddling two mapped windows
+    long boundary = 64L * 1024 * 1024;
+    file = mini_fopen("test_mapw.bin", 'M');
+    mini_fseek(file, boundary - 10, SEEK_SET);
+    mini_fwrite(data, 1, 20, file);
+    mini_fclose(file);
+    fd = open("test_mapw.bin", O_RDONLY);
+    got = pread(fd, back, 30, boundary - 10);
+    close(fd);
+    print_test_result(got == 20 && memcmp(back, data, 20) == 0, "Test 3 - Write across the window boundary");
+
+    // Write-only, and special files fall back to buffered writes
+    file = mini_fopen("test_mapw.bin", 'M');
+    int read_result = mini_fread(back, 1, 10, file);
+    mini_fclose(file);
+    file = mini_fopen("/dev/null", 'M');
+    int null_result = file ? mini_fwrite(data, 1, 100, file) : -1;
+    mini_fclose(file);
+    print_test_result(read_result == -1 && null_result == 100, "Test 4 - Read rejected, /dev/null falls back");
+
+    // A stream flushed but never closed is trimmed by the exit flush
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        file = mini_fopen("test_mapw.bin", 'M');
+        mini_fwrite(data, 1, 5000, file);
+        mini_fflush(file);
+        mini_fwrite(data, 1, 5000, file);
+        exit(0);
+    }
+    waitpid(child, NULL, 0);
+    int exit_size = stat("test_mapw.bin", &info) == 0 ? (int)info.st_size : -1;
+    print_test_result(exit_size == 10000, "Test 5 - Exit flush trims an unclosed stream");
+    free(data);
+    free(back);
+    unlink("test_mapw.bin");
+}
+
+// Points fd at path and returns a copy of the previous descriptor
+static int redirect_fd(int fd, char* path, int flags) {
+    int saved = dup(fd);
+    int target = open(path, flags, 0644);
+    dup2(target, fd);
+    close(target);
+    return saved;
+}
+
+static void restore_fd(int fd, int saved) {
+    dup2(saved, fd);
+    close(saved);
+}
+
+static int read_whole(char* path, char* dest, int capacity) {
+    int fd = open(path, O_RDONLY);
+    int got = read(fd, dest, capacity);
+    close(fd);
+    return got;
+}
+
+static void ignore_signal(int sig) {
+    (void)sig;
+}
+
+void test_mini_std_streams() {
+    print_test_header("mini_stdin / mini_stdout / mini_stderr");
+
+    print_test_result(mini_stdin->fd == 0 && mini_stdout->fd == 1 && mini_stderr->fd == 2
+                      && mini_stderr->buffer_mode == MINI_IONBF,
+                      "Test 1 - Standard streams are MYFILE instances");
+
+    // mini_printf and mini_fwrite share the stdout buffer, without padding
+    char back[64];
+    fflush(stdout);
+    mini_fflush(mini_stdout);
+    int saved = redirect_fd(STDOUT_FILENO, "test_std.txt", O_WRONLY | O_CREAT | O_TRUNC);
+    mini_printf("hello ");
+    mini_printf_n("world\nxx", 6);
+    mini_fwrite("!\n", 1, 2, mini_stdout);
+    mini_fflush(mini_stdout);
+    mini_printf("pending");
+    int before_exit_flush = read_whole("test_std.txt", back, sizeof(back));
+    mini_exit_flush();
+    int got = read_whole("test_std.txt", back, sizeof(back));
+    restore_fd(STDOUT_FILENO, saved);
+    print_test_result(got == 21 && memcmp(back, "hello world\n!\npending", 21) == 0,
+                      "Test 2 - mini_printf goes through mini_stdout");
+    print_test_result(before_exit_flush == 14, "Test 3 - Pending output is written by mini_exit_flush");
+
+    // mini_perror writes one line on stderr; mini_fclose leaves it open
+    saved = redirect_fd(STDERR_FILENO, "test_std.txt", O_WRONLY | O_CREAT | O_TRUNC);
+    errno = ENOENT;
+    mini_perror("open");
+    int closed = mini_fclose(mini_stderr);
+    mini_fwrite("ok\n", 1, 3, mini_stderr);
+    got = read_whole("test_std.txt", back, sizeof(back));
+    restore_fd(STDERR_FILENO, saved);
+    print_test_result(closed == 0 && got == 12 && memcmp(back, "open : 2\nok\n", 12) == 0,
+                      "Test 4 - mini_perror on mini_stderr, mini_fclose keeps it open");
+
+    // A program whose output is an exact multiple of the buffer must still
+    // exit: the atexit flush finds nothing pending and returns
+    fflush(stdout);
+    mini_fflush(mini_stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        alarm(5); // A hang in the exit flush kills the child
+        redirect_fd(STDOUT_FILENO, "test_std.txt", O_WRONLY | O_CREAT | O_TRUNC);
+        int size = mini_stdout->buffer_size;
+        for (int i = 0; i < size / 4; i++) {
+            mini_printf("abc\n");
+        }
+        exit(0);
+    }
+    int status = -1;
+    waitpid(child, &status, 0);
+    struct stat info;
+    int stat_ok = stat("test_std.txt", &info) == 0;
+    print_test_result(WIFEXITED(status) && WEXITSTATUS(status) == 0 && stat_ok
+                      && info.st_size == mini_stdout->buffer_size / 4 * 4,
+                      "Test 5 - Exit after printing exactly one buffer");
+
+    // Writes blocked on a full pipe are interrupted by signals without
+    // SA_RESTART: write() fails with EINTR and must be retried
+    int pipe_fds[2];
+    pipe(pipe_fds);
+    fflush(stdout);
+    child = fork();
+    if (child == 0) {
+        alarm(5);
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = ignore_signal;
+        sigaction(SIGUSR1, &action, NULL);
+        close(pipe_fds[0]);
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[1]);
+        static char payload[1 << 18];
+        memset(payload, 'p', sizeof(payload));
+        int written = mini_fwrite(payload, 1, sizeof(payload), mini_stdout);
+        exit(written == (int)sizeof(payload) && mini_fflush(mini_stdout) == 0 ? 0 : 1);
+    }
+    close(pipe_fds[1]);
+    for (int i = 0; i < 10; i++) {
+        usleep(10000);
+        kill(child, SIGUSR1);
+    }
+    long drained = 0;
+    int n;
+    while ((n = read(pipe_fds[0], back, sizeof(back))) > 0) {
+        drained += n;
+    }
+    close(pipe_fds[0]);
+    waitpid(child, &status, 0);
+    print_test_result(WIFEXITED(status) && WEXITSTATUS(status) == 0 && drained == 1 << 18,
+                      "Test 6 - Writes interrupted by a signal are retried");
+
+    // mini_scanf reads through the mini_stdin buffer
+    int fd = open("test_std.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    write(fd, "first\nsecond\n", 13);
+    close(fd);
+    saved = redirect_fd(STDIN_FILENO, "test_std.txt", O_RDONLY);
+    char first[16], second[16];
+    int len1 = mini_scanf(first, 15);
+    int len2 = mini_scanf(second, 15);
+    int len3 = mini_scanf(back, 15);
+    restore_fd(STDIN_FILENO, saved);
+    print_test_result(len1 == 5 && strcmp(first, "first") == 0 && len2 == 6 && strcmp(second, "second") == 0
+                      && len3 == 0, "Test 7 - mini_scanf through mini_stdin");
+    unlink("test_std.txt");
+}
+
+void test_mini_fmemopen() {
+    print_test_header("mini_fmemopen");
+
+    // Reading a caller buffer: lines point into it, no copy
+    char text[] = "line one\nline two\nlast";
+    MYFILE* file = mini_fmemopen(text, sizeof(text) - 1, 'r');
+    int len;
+    char* line = mini_fgetline(file, &len);
+    char word[8] = {0};
+    int got = mini_fread(word, 1, 4, file);
+    mini_fseek(file, -4, SEEK_END);
+    char tail[8] = {0};
+    int got_tail = mini_fread(tail, 1, sizeof(tail), file);
+    int written = mini_fwrite("x", 1, 1, file);
+    mini_fclose(file);
+    print_test_result(line == text && len == 9 && got == 4 && strcmp(word, "line") == 0
+                      && got_tail == 4 && strcmp(tail, "last") == 0 && written == -1,
+                      "Test 1 - Read, getline without copy and seek on a buffer");
+
+    // A fixed buffer refuses what does not fit
+    char fixed[16];
+    file = mini_fmemopen(fixed, sizeof(fixed), 'w');
+    int first = mini_fwrite("0123456789", 1, 10, file);
+    int second = mini_fwrite("0123456789", 1, 10, file);
+    int error = errno;
+    long view_len;
+    char* view = mini_fmap_view(file, &view_len);
+    mini_fclose(file);
+    print_test_result(first == 10 && second == -1 && error == ENOSPC && view == fixed && view_len == 10
+                      && memcmp(fixed, "0123456789", 10) == 0, "Test 2 - Fixed buffer is full");
+
+    // A growable sink: no system call, contents read in place
+    file = mini_fmemopen(NULL, 0, 'w');
+    char record[100];
+    for (int i = 0; i < 100; i++) {
+        record[i] = (char)('a' + i % 26);
+    }
+    record[99] = '\n';
+    int total = 0;
+    for (int i = 0; i < 5000; i++) {
+        total += mini_fwrite(record, 1, sizeof(record), file);
+    }
+    view = mini_fmap_view(file, &view_len);
+    int same = view_len == 500000;
+    for (long i = 0; same && i < view_len; i += sizeof(record)) {
+        same = memcmp(view + i, record, sizeof(record)) == 0;
+    }
+    int read_back = mini_fread(word, 1, 1, file);
+    mini_iostats stats;
+    mini_fstats(file, &stats);
+    print_test_result(total == 500000 && same && read_back == -1 && stats.write_calls == 0 && stats.read_calls == 0,
+                      "Test 3 - Growable sink without system calls");
+
+    // Pipeline: the sink contents are read by the next stage without copy
+    MYFILE* next = mini_fmemopen(view, view_len, 'r');
+    int lines = 0;
+    while ((line = mini_fgetline(next, &len)) != NULL) {
+        lines += len == 100 && line[99] == '\n';
+    }
+    mini_fclose(next);
+    mini_fclose(file);
+    print_test_result(lines == 5000, "Test 4 - Sink feeds a reader");
+
+    // Read-write: hole filled with zeros, positioned writes, copy to a file
+    file = mini_fmemopen(NULL, 0, 'b');
+    mini_fwrite("abc", 1, 3, file);
+    mini_fseek(file, 6, SEEK_SET);
+    mini_fwrite("xyz", 1, 3, file);
+    mini_fpwrite(file, "B", 1, 1);
+    mini_fseek(file, 0, SEEK_SET);
+    MYFILE* out = mini_fopen("test_fmemopen.txt", 'w');
+    long copy = mini_fcopy(out, file, -1);
+    mini_fclose(out);
+    mini_fclose(file);
+    char back[16] = {0};
+    got = read_whole("test_fmemopen.txt", back, sizeof(back));
+    print_test_result(copy == 9 && got == 9 && memcmp(back, "aBc\0\0\0xyz", 9) == 0,
+                      "Test 5 - Read-write stream with hole, copied to a file");
+    unlink("test_fmemopen.txt");
+}
+
 void test_mini_io(void) {
     test_mini_fopen();
     test_mini_memcpy();
@@ -396,14 +1623,182 @@ void test_mini_io(void) {
     test_mini_fwrite();
     test_mini_fflush();
     test_mini_fclose();
+    test_mini_setvbuf();
+    test_mini_fmap();
+    test_mini_async();
+    test_mini_iov();
+    test_mini_fseek();
+    test_mini_freadahead();
+    test_mini_fgetline();
+    test_mini_flockfile();
+    test_mini_open_files();
+    test_mini_direct();
+    test_mini_fcopy();
+    test_mini_lz();
+    test_mini_buffer_pool();
+    test_mini_fstats();
+    test_mini_fsetsync();
+    test_mini_mapw();
+    test_mini_std_streams();
+    test_mini_fmemopen();
+}
+
+static int count_ac_match(int pattern, int start, void* ctx) {
+    int* counts = (int*)ctx;
+    counts[pattern]++;
+    (void)start;
+    return 0;
+}
+
+void test_mini_search(void) {
+    print_test_header("mini_search");
+
+    char text[] = "the quick brown fox jumps over the lazy dog";
+    print_test_result(mini_strstr(text, "fox") == text + 16, "Test 1 - Find substring");
+    print_test_result(mini_strstr(text, "cat") == NULL, "Test 2 - Missing substring");
+    print_test_result(mini_memchr(text, 'z', (int)strlen(text)) == text + 37, "Test 3 - mini_memchr");
+
+    // Repetitive haystack and needle: exercises the Two-Way fallback
+    char periodic[4096];
+    memset(periodic, 'a', sizeof(periodic) - 1);
+    periodic[sizeof(periodic) - 1] = '\0';
+    periodic[4000] = 'b';
+    char needle[200];
+    memset(needle, 'a', sizeof(needle) - 2);
+    needle[sizeof(needle) - 2] = 'b';
+    needle[sizeof(needle) - 1] = '\0';
+    print_test_result(mini_strstr(periodic, needle) == strstr(periodic, needle),
+                      "Test 4 - Periodic needle");
+
+    // Random small-alphabet strings compared against the C library
+    int passed = 1;
+    char hay[300], pat[8];
+    srand(42);
+    for (int round = 0; round < 2000 && passed; round++) {
+        int hlen = rand() % 299, plen = 1 + rand() % 7;
+        for (int i = 0; i < hlen; i++) hay[i] = 'a' + rand() % 3;
+        for (int i = 0; i < plen; i++) pat[i] = 'a' + rand() % 3;
+        hay[hlen] = '\0';
+        pat[plen] = '\0';
+        passed = mini_strstr(hay, pat) == strstr(hay, pat);
+    }
+    print_test_result(passed, "Test 5 - Random strings match strstr");
+
+    char* patterns[] = {"he", "she", "his", "hers"};
+    int counts[4] = {0, 0, 0, 0};
+    MINI_AC* ac = mini_ac_new(patterns, 4);
+    int matches = mini_ac_scan(ac, "ushers", 6, count_ac_match, counts);
+    print_test_result(matches == 3 && counts[0] == 1 && counts[1] == 1 && counts[3] == 1,
+                      "Test 6 - Aho-Corasick multi-pattern scan");
+    mini_ac_free(ac);
+
+    // Every index of a repeated pattern is reported
+    char* repeated[] = {"ab", "b", "ab", "ab"};
+    int hits[4] = {0, 0, 0, 0};
+    ac = mini_ac_new(repeated, 4);
+    matches = mini_ac_scan(ac, "xab", 3, count_ac_match, hits);
+    print_test_result(matches == 4 && hits[0] == 1 && hits[1] == 1 && hits[2] == 1 && hits[3] == 1,
+                      "Test 7 - Duplicate patterns all match");
+    mini_ac_free(ac);
 }
 
+void test_mini_strview(void) {
+    print_test_header("mini_strview");
+
+    // Directory entry in the td_fs "name inode\n" format
+    char entry[] = "  notes.txt 42\n";
+    mini_strview line = mini_sv_trim(mini_sv(entry));
+    mini_strview name, inode_str;
+    int inode = 0;
+    int split = mini_sv_split(line, ' ', &name, &inode_str);
+    print_test_result(split && mini_sv_equals(name, "notes.txt"), "Test 1 - Split and trim");
+    print_test_result(mini_sv_to_int(inode_str, &inode) == 0 && inode == 42, "Test 2 - Parse integer");
+    print_test_result(mini_sv_find(line, mini_sv("txt")) == 6, "Test 3 - Find in view");
+
+    char args[] = "-l,,-a, dir";
+    mini_tokenizer tok;
+    mini_strview token;
+    int count = 0;
+    mini_tok_init(&tok, mini_sv(args), ", ");
+    while (mini_tok_next(&tok, &token)) {
+        count++;
+    }
+    print_test_result(count == 3 && mini_sv_equals(token, "dir"), "Test 4 - Tokenizer skips empty tokens");
+    print_test_result(strcmp(args, "-l,,-a, dir") == 0, "Test 5 - Source left untouched");
+
+    int low = 0, high = 0, unchanged = 7;
+    int passed = mini_sv_to_int(mini_sv("-2147483648"), &low) == 0 && low == INT_MIN
+              && mini_sv_to_int(mini_sv("+2147483647"), &high) == 0 && high == INT_MAX
+              && mini_sv_to_int(mini_sv("2147483648"), &unchanged) == -1
+              && mini_sv_to_int(mini_sv("-2147483649"), &unchanged) == -1
+              && mini_sv_to_int(mini_sv("99999999999"), &unchanged) == -1 && unchanged == 7;
+    print_test_result(passed, "Test 6 - Integer limits, overflow rejected");
+}
+
+void test_mini_strbuf(void) {
+    print_test_header("mini_strbuf");
+
+    mini_strbuf sb;
+    mini_strbuf_init(&sb);
+    mini_strbuf_append_str(&sb, "size ");
+    mini_strbuf_append_int(&sb, -1234);
+    mini_strbuf_append_char(&sb, '\n');
+    print_test_result(strcmp(mini_strbuf_cstr(&sb), "size -1234\n") == 0, "Test 1 - Append string, number, char");
+
+    // Many small appends go through several geometric reallocations
+    mini_strbuf_clear(&sb);
+    int passed = 1;
+    for (int i = 0; i < 5000; i++) {
+        mini_strbuf_append_char(&sb, 'a' + i % 26);
+    }
+    for (int i = 0; i < 5000 && passed; i++) {
+        passed = sb.data[i] == 'a' + i % 26;
+    }
+    print_test_result(passed && sb.len == 5000 && sb.capacity >= 5001, "Test 2 - Growth keeps content");
+
+    struct iovec iov = mini_strbuf_iov(&sb);
+    print_test_result(iov.iov_base == sb.data && iov.iov_len == 5000, "Test 3 - iovec view without copy");
+
+    // Sizes that would overflow int are refused before any allocation
+    char* data = sb.data;
+    int capacity = sb.capacity;
+    passed = mini_strbuf_reserve(&sb, INT_MAX) == -1
+          && mini_strbuf_reserve(&sb, INT_MAX - 5000) == -1
+          && mini_strbuf_append(&sb, "x", INT_MAX - 4000) == -1;
+    print_test_result(passed && sb.data == data && sb.capacity == capacity && sb.len == 5000,
+                      "Test 4 - Overflowing reserve rejected");
+    mini_strbuf_free(&sb);
+}
+
+void test_mini_utf8(void) {
+    print_test_header("mini_utf8");
+
+    char text[] = "caract\xc3\xa8re sp\xc3\xa9" "cial \xe6\x97\xa5\xe6\x9c\xac with ascii padding";
+    int len = (int)strlen(text);
+    print_test_result(mini_utf8_validate(text, len), "Test 1 - Valid UTF-8");
+    print_test_result(mini_utf8_count(text, len) == len - 6, "Test 2 - Code point count");
+    // e-grave and e-acute take 1 column (2 bytes), the two CJK characters 2 columns (3 bytes)
+    print_test_result(mini_utf8_width(text, len) == len - 4, "Test 3 - Display width");
+
+    int passed = !mini_utf8_validate("\xc0\x80", 2)          // overlong
+              && !mini_utf8_validate("\xed\xa0\x80", 3)      // surrogate
+              && !mini_utf8_validate("abc\xe6\x97", 5)        // truncated
+              && !mini_utf8_validate("\xf4\x90\x80\x80", 4); // above U+10FFFF
+    print_test_result(passed, "Test 4 - Invalid sequences rejected");
+
+    // "caractè" is 7 columns but 8 bytes
+    print_test_result(mini_utf8_truncate(text, len, 7) == 8, "Test 5 - Truncate on a code point boundary");
+}
 
 // Fonction principale pour lancer tous les tests
 int main(void) {
     //test_mini_memory();
     //test_mini_string();
     test_mini_io();
+    test_mini_search();
+    test_mini_strview();
+    test_mini_strbuf();
+    test_mini_utf8();
 
     // Affichage des tests échoués avant d'exécuter mini_exit
     print_failed_tests();
@@ -0,0 +1,398 @@
+#include <sys/errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "mini_lib.h"
+
+#define AIO_DEFAULT_DEPTH 256
+#define AIO_THREADS 4
+
+// Requête en attente ou en cours (utilisée par le pool de threads)
+typedef struct AioJob {
+    int id;
+    int write;
+    int fd;
+    void* buffer;
+    int size;
+    long offset;
+    int result;
+    struct AioJob* next;
+} AioJob;
+
+typedef struct {
+    int backend;        // MINI_AIO_URING ou MINI_AIO_THREADS, 0 si non initialisé
+    int depth;
+    int next_id;
+    int queued;         // préparées mais pas encore soumises
+    int in_flight;      // soumises, complétion non récupérée
+
+    // io_uring : anneaux partagés avec le noyau
+    int ring_fd;
+    void* sq_ring;
+    void* cq_ring;
+    long sq_ring_size;
+    long cq_ring_size;
+    struct io_uring_sqe* sqes;
+    long sqes_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    // Pool de threads : file des requêtes préparées, à traiter, terminées
+    pthread_t threads[AIO_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    AioJob* prepared;
+    AioJob* prepared_tail;
+    AioJob* todo;
+    AioJob* todo_tail;
+    AioJob* done;
+    int stopping;
+} AioContext;
+
+static AioContext aio;
+
+static int uring_setup(int depth) {
+    struct io_uring_params params;
+    mini_memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, depth, &params);
+    if (fd < 0) {
+        return -1;
+    }
+
+    aio.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    aio.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    // Noyaux récents : un seul mmap pour les deux anneaux
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (aio.cq_ring_size > aio.sq_ring_size) {
+            aio.sq_ring_size = aio.cq_ring_size;
+        }
+        aio.cq_ring_size = aio.sq_ring_size;
+    }
+    aio.sq_ring = mmap(NULL, aio.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQ_RING);
+    if (aio.sq_ring == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        aio.cq_ring = aio.sq_ring;
+    } else {
+        aio.cq_ring = mmap(NULL, aio.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd, IORING_OFF_CQ_RING);
+        if (aio.cq_ring == MAP_FAILED) {
+            munmap(aio.sq_ring, aio.sq_ring_size);
+            close(fd);
+            return -1;
+        }
+    }
+    aio.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    aio.sqes = mmap(NULL, aio.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQES);
+    if (aio.sqes == MAP_FAILED) {
+        if (aio.cq_ring != aio.sq_ring) {
+            munmap(aio.cq_ring, aio.cq_ring_size);
+        }
+        munmap(aio.sq_ring, aio.sq_ring_size);
+        close(fd);
+        return -1;
+    }
+
+    char* sq = (char*)aio.sq_ring;
+    char* cq = (char*)aio.cq_ring;
+    aio.sq_head = (unsigned*)(sq + params.sq_off.head);
+    aio.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    aio.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    aio.sq_array = (unsigned*)(sq + params.sq_off.array);
+    aio.cq_head = (unsigned*)(cq + params.cq_off.head);
+    aio.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    aio.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    aio.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    aio.ring_fd = fd;
+    aio.depth = params.sq_entries;
+    return 0;
+}
+
+static void* aio_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&aio.lock);
+    for (;;) {
+        while (!aio.todo && !aio.stopping) {
+            pthread_cond_wait(&aio.work_ready, &aio.lock);
+        }
+        if (!aio.todo) {
+            break;
+        }
+        AioJob* job = aio.todo;
+        aio.todo = job->next;
+        if (!aio.todo) {
+            aio.todo_tail = NULL;
+        }
+        pthread_mutex_unlock(&aio.lock);
+
+        // Position toujours explicite : les threads se partagent le descripteur
+        if (job->write) {
+            job->result = pwrite(job->fd, job->buffer, job->size, job->offset);
+        } else {
+            job->result = pread(job->fd, job->buffer, job->size, job->offset);
+        }
+        if (job->result < 0) {
+            job->result = -errno;   // même convention que io_uring
+        }
+
+        pthread_mutex_lock(&aio.lock);
+        job->next = aio.done;
+        aio.done = job;
+        pthread_cond_broadcast(&aio.work_done);
+    }
+    pthread_mutex_unlock(&aio.lock);
+    return NULL;
+}
+
+static int threads_setup(int depth) {
+    pthread_mutex_init(&aio.lock, NULL);
+    pthread_cond_init(&aio.work_ready, NULL);
+    pthread_cond_init(&aio.work_done, NULL);
+    aio.prepared = aio.prepared_tail = NULL;
+    aio.todo = aio.todo_tail = NULL;
+    aio.done = NULL;
+    aio.stopping = 0;
+    for (int i = 0; i < AIO_THREADS; i++) {
+        if (pthread_create(&aio.threads[i], NULL, aio_worker, NULL) != 0) {
+            // Arrêter les threads déjà lancés
+            pthread_mutex_lock(&aio.lock);
+            aio.stopping = 1;
+            pthread_cond_broadcast(&aio.work_ready);
+            pthread_mutex_unlock(&aio.lock);
+            while (--i >= 0) {
+                pthread_join(aio.threads[i], NULL);
+            }
+            return -1;
+        }
+    }
+    aio.depth = depth;
+    return 0;
+}
+
+int mini_async_init(int depth, int backend) {
+    if (aio.backend) {
+        return aio.backend;
+    }
+    if (depth <= 0) {
+        depth = AIO_DEFAULT_DEPTH;
+    }
+    aio.next_id = 0;
+    aio.queued = 0;
+    aio.in_flight = 0;
+    if (backend != MINI_AIO_THREADS && uring_setup(depth) == 0) {
+        aio.backend = MINI_AIO_URING;
+    } else if (backend != MINI_AIO_URING && threads_setup(depth) == 0) {
+        aio.backend = MINI_AIO_THREADS;
+    } else {
+        errno = ENOSYS;
+        return -1;
+    }
+    return aio.backend;
+}
+
+void mini_async_shutdown(void) {
+    if (aio.backend == MINI_AIO_URING) {
+        munmap(aio.sqes, aio.sqes_size);
+        if (aio.cq_ring != aio.sq_ring) {
+            munmap(aio.cq_ring, aio.cq_ring_size);
+        }
+        munmap(aio.sq_ring, aio.sq_ring_size);
+        close(aio.ring_fd);
+    } else if (aio.backend == MINI_AIO_THREADS) {
+        pthread_mutex_lock(&aio.lock);
+        aio.stopping = 1;
+        pthread_cond_broadcast(&aio.work_ready);
+        pthread_mutex_unlock(&aio.lock);
+        for (int i = 0; i < AIO_THREADS; i++) {
+            pthread_join(aio.threads[i], NULL);
+        }
+        // Requêtes jamais récupérées
+        AioJob* lists[3] = {aio.prepared, aio.todo, aio.done};
+        for (int l = 0; l < 3; l++) {
+            while (lists[l]) {
+                AioJob* next = lists[l]->next;
+                mini_free(lists[l]);
+                lists[l] = next;
+            }
+        }
+        pthread_mutex_destroy(&aio.lock);
+        pthread_cond_destroy(&aio.work_ready);
+        pthread_cond_destroy(&aio.work_done);
+    }
+    aio.backend = 0;
+}
+
+// Prépare une requête sans la soumettre ; retourne son identifiant
+static int aio_prepare(MYFILE* file, int is_write, void* buffer, int size, long offset) {
+    if (!file || !buffer || size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!aio.backend && mini_async_init(0, MINI_AIO_AUTO) == -1) {
+        return -1;
+    }
+    // Chaque requête soumise doit avoir une place dans la file de complétion
+    if (aio.queued + aio.in_flight >= aio.depth) {
+        errno = EAGAIN;
+        return -1;
+    }
+    AioJob* job = NULL;
+    if (aio.backend == MINI_AIO_THREADS) {
+        job = (AioJob*)mini_calloc(sizeof(AioJob), 1);
+        if (!job) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    // Les écritures en attente dans le flux précèdent la requête, et une
+    // position implicite est celle du flux, réservée dès maintenant : des
+    // requêtes qui s'exécutent dans le désordre gardent chacune leur place
+    long position = mini_fhandoff(file, offset < 0 ? size : 0);
+    if (position < 0) {
+        if (job) {
+            mini_free(job);
+        }
+        return -1;
+    }
+    if (offset < 0) {
+        offset = position;
+    }
+    int id = aio.next_id++;
+
+    if (aio.backend == MINI_AIO_URING) {
+        unsigned tail = *aio.sq_tail;
+        unsigned index = tail & *aio.sq_mask;
+        struct io_uring_sqe* sqe = &aio.sqes[index];
+        mini_memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = file->fd;
+        sqe->addr = (unsigned long)buffer;
+        sqe->len = size;
+        sqe->off = (unsigned long long)offset;
+        sqe->user_data = id;
+        aio.sq_array[index] = index;
+        // Le noyau ne doit voir la nouvelle queue qu'une fois l'entrée remplie
+        __atomic_store_n(aio.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    } else {
+        job->id = id;
+        job->write = is_write;
+        job->fd = file->fd;
+        job->buffer = buffer;
+        job->size = size;
+        job->offset = offset;
+        job->next = NULL;
+        if (aio.prepared_tail) {
+            aio.prepared_tail->next = job;
+        } else {
+            aio.prepared = job;
+        }
+        aio.prepared_tail = job;
+    }
+    aio.queued++;
+    return id;
+}
+
+int mini_fread_async(MYFILE* file, void* buffer, int size, long offset) {
+    return aio_prepare(file, 0, buffer, size, offset);
+}
+
+int mini_fwrite_async(MYFILE* file, void* buffer, int size, long offset) {
+    return aio_prepare(file, 1, buffer, size, offset);
+}
+
+int mini_async_submit(void) {
+    if (!aio.backend || aio.queued == 0) {
+        return 0;
+    }
+    int count = aio.queued;
+    if (aio.backend == MINI_AIO_URING) {
+        // Un seul appel système pour toutes les requêtes préparées
+        int submitted = 0;
+        while (submitted < count) {
+            int result = syscall(__NR_io_uring_enter, aio.ring_fd, count - submitted, 0, 0, NULL, 0);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                aio.queued -= submitted;
+                aio.in_flight += submitted;
+                return -1;
+            }
+            submitted += result;
+        }
+    } else {
+        pthread_mutex_lock(&aio.lock);
+        if (aio.todo_tail) {
+            aio.todo_tail->next = aio.prepared;
+        } else {
+            aio.todo = aio.prepared;
+        }
+        aio.todo_tail = aio.prepared_tail;
+        aio.prepared = aio.prepared_tail = NULL;
+        pthread_cond_broadcast(&aio.work_ready);
+        pthread_mutex_unlock(&aio.lock);
+    }
+    aio.queued = 0;
+    aio.in_flight += count;
+    return count;
+}
+
+int mini_async_complete(int* id, int* result, int wait) {
+    if (!aio.backend) {
+        return 0;
+    }
+    // Une requête préparée mais non soumise ne se terminerait jamais
+    if (aio.queued > 0 && mini_async_submit() == -1) {
+        return -1;
+    }
+    if (aio.in_flight == 0) {
+        return 0;
+    }
+
+    if (aio.backend == MINI_AIO_URING) {
+        unsigned head = *aio.cq_head;
+        while (head == __atomic_load_n(aio.cq_tail, __ATOMIC_ACQUIRE)) {
+            if (!wait) {
+                return 0;
+            }
+            if (syscall(__NR_io_uring_enter, aio.ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+                && errno != EINTR) {
+                return -1;
+            }
+        }
+        struct io_uring_cqe* cqe = &aio.cqes[head & *aio.cq_mask];
+        if (id) *id = (int)cqe->user_data;
+        if (result) *result = cqe->res;
+        __atomic_store_n(aio.cq_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        pthread_mutex_lock(&aio.lock);
+        while (!aio.done) {
+            if (!wait) {
+                pthread_mutex_unlock(&aio.lock);
+                return 0;
+            }
+            pthread_cond_wait(&aio.work_done, &aio.lock);
+        }
+        AioJob* job = aio.done;
+        aio.done = job->next;
+        pthread_mutex_unlock(&aio.lock);
+        if (id) *id = job->id;
+        if (result) *result = job->result;
+        mini_free(job);
+    }
+    aio.in_flight--;
+    return 1;
+}
@@ -1,55 +1,408 @@
-
+#define _GNU_SOURCE // O_DIRECT
 
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <limits.h>
 #include <sys/errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "mini_lib.h"
 
-#define IOBUFFER_SIZE 2048
+#define IOBUFFER_SIZE 2048 // Taille par défaut si fstat ne donne pas st_blksize
+#define READAHEAD_BLOCK (512 * 1024) // Taille minimale d'un bloc en lecture anticipée
+#define READAHEAD_WINDOW 4           // Blocs annoncés au noyau au-delà du bloc lu
+
+#define OPEN_FILES_MIN 64 // Taille initiale de la table des flux ouverts
+#define DIRECT_ALIGN 4096           // Alignement des tampons, positions et tailles en O_DIRECT
+#define DIRECT_BUFFER (1024 * 1024) // Taille minimale des tampons en O_DIRECT
+#define COPY_CHUNK (1L << 30)       // Octets demandés au noyau par appel de mini_fcopy
+#define COPY_BUFFER (1024 * 1024)   // Tampon de la boucle de secours de mini_fcopy
+#define COPY_PIPE (1024 * 1024)     // Capacité demandée pour le tube de splice (mini_fcopy)
+#define LZ_BLOCK (64 * 1024)        // Octets décompressés par bloc (modes 'z' et 'Z')
+#define LZ_HEADER 16                // Signature et taille de bloc en tête de fichier
+#define LZ_STORED 0x80000000u       // Bloc stocké tel quel (incompressible)
+#define MAPW_WINDOW (64L * 1024 * 1024) // Fenêtre projetée en écriture (mode 'M')
+#define MAPW_EXTENT (64L * 1024 * 1024) // Granularité d'agrandissement du fichier (mode 'M')
+#define POOL_MIN_SHIFT 12           // Plus petite classe du pool de tampons : 4 Ko
+#define POOL_CLASSES 9              // Classes de 4 Ko à 1 Mo (puissances de deux)
+#define POOL_THREAD_CACHE 4         // Tampons gardés par thread et par classe
+#define POOL_SHARED_MAX (16L * 1024 * 1024) // Octets gardés dans le pool partagé
+#define EXIT_FLUSH_RETRIES 1000     // Passes de mini_exit_flush sur des flux verrouillés ailleurs
+#define MEM_INITIAL (64 * 1024)     // Capacité initiale d'un flux mémoire extensible
 
-#define MAX_FILES 10 // Définir le nombre maximum de fichiers ouverts simultanément
+// Flux ouverts, indexés par descripteur : enregistrement et retrait en O(1)
+static MYFILE** open_files = NULL;
+static int open_files_capacity = 0;
+static pthread_mutex_t open_files_lock = PTHREAD_MUTEX_INITIALIZER;
 
-typedef struct OpenFile {
-    MYFILE* file;
-    struct OpenFile* next;
-} OpenFile;
+// Flux standard : statiques, jamais libérés, vidés par mini_exit_flush comme
+// les autres. Tailles et mode de la sortie fixés par std_streams_init.
+static MYFILE stdin_stream = {.fd = STDIN_FILENO, .mode = 'r', .ind_read = -1, .end_read = -1,
+                              .ind_write = -1, .buffer_size = IOBUFFER_SIZE, .buffer_mode = MINI_IOFBF};
+static MYFILE stdout_stream = {.fd = STDOUT_FILENO, .mode = 'w', .ind_read = -1, .end_read = -1,
+                               .ind_write = -1, .buffer_size = IOBUFFER_SIZE, .buffer_mode = MINI_IOLBF};
+static MYFILE stderr_stream = {.fd = STDERR_FILENO, .mode = 'w', .ind_read = -1, .end_read = -1,
+                               .ind_write = -1, .buffer_size = IOBUFFER_SIZE, .buffer_mode = MINI_IONBF};
+MYFILE* mini_stdin = &stdin_stream;
+MYFILE* mini_stdout = &stdout_stream;
+MYFILE* mini_stderr = &stderr_stream;
 
-static OpenFile* open_files = NULL; // Liste des fichiers ouverts
+// Flux dont le tampon d'écriture contient des données : seuls ceux-là
+// sont parcourus par mini_exit_flush
+static MYFILE* dirty_files = NULL;
+static pthread_mutex_t dirty_files_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void add_open_file(MYFILE* file) {
-    OpenFile* new_entry = (OpenFile*)mini_calloc(sizeof(OpenFile), 1);
-    if (new_entry) {
-        new_entry->file = file;
-        new_entry->next = open_files;
-        open_files = new_entry;
+    pthread_mutex_lock(&open_files_lock);
+    if (file->fd >= open_files_capacity) {
+        // Table doublée jusqu'à contenir le descripteur
+        int capacity = open_files_capacity ? open_files_capacity : OPEN_FILES_MIN;
+        while (capacity <= file->fd) {
+            capacity *= 2;
+        }
+        MYFILE** table = (MYFILE**)mini_calloc(sizeof(MYFILE*), capacity);
+        if (!table) {
+            pthread_mutex_unlock(&open_files_lock);
+            return; // Le flux fonctionne, il ne sera simplement pas vidé à la sortie
+        }
+        if (open_files) {
+            mini_memcpy(table, open_files, open_files_capacity * (int)sizeof(MYFILE*));
+            mini_free(open_files);
+        }
+        open_files = table;
+        open_files_capacity = capacity;
     }
+    open_files[file->fd] = file;
+    pthread_mutex_unlock(&open_files_lock);
 }
 void remove_open_file(MYFILE* file) {
-    OpenFile** current = &open_files;
-    while (*current) {
-        if ((*current)->file == file) {
-            OpenFile* to_delete = *current;
-            *current = to_delete->next;
-            mini_free(to_delete);
-            return;
+    pthread_mutex_lock(&open_files_lock);
+    if (file->fd >= 0 && file->fd < open_files_capacity && open_files[file->fd] == file) {
+        open_files[file->fd] = NULL;
+    }
+    pthread_mutex_unlock(&open_files_lock);
+}
+
+// Appelées avec le verrou du flux : le drapeau dirty évite le verrou
+// global sauf au passage vide <-> non vide du tampon d'écriture
+static void mark_dirty(MYFILE* file) {
+    if (file->dirty) {
+        return;
+    }
+    pthread_mutex_lock(&dirty_files_lock);
+    file->dirty = 1;
+    file->dirty_prev = NULL;
+    file->dirty_next = dirty_files;
+    if (dirty_files) {
+        dirty_files->dirty_prev = file;
+    }
+    dirty_files = file;
+    pthread_mutex_unlock(&dirty_files_lock);
+}
+
+// Retire le flux de la liste, verrou de la liste déjà pris
+static void unlink_dirty(MYFILE* file) {
+    if (file->dirty_prev) {
+        file->dirty_prev->dirty_next = file->dirty_next;
+    } else {
+        dirty_files = file->dirty_next;
+    }
+    if (file->dirty_next) {
+        file->dirty_next->dirty_prev = file->dirty_prev;
+    }
+    file->dirty = 0;
+    file->dirty_prev = NULL;
+    file->dirty_next = NULL;
+}
+
+static void mark_clean(MYFILE* file) {
+    if (!file->dirty) {
+        return;
+    }
+    pthread_mutex_lock(&dirty_files_lock);
+    if (file->dirty) {
+        unlink_dirty(file);
+    }
+    pthread_mutex_unlock(&dirty_files_lock);
+}
+
+// Taille de tampon par défaut : la taille de bloc préférée du fichier
+static int default_buffer_size(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_blksize <= 0) {
+        return IOBUFFER_SIZE;
+    }
+    return (int)info.st_blksize;
+}
+
+// Pool des tampons de flux : alignés sur une page (donc utilisables en
+// O_DIRECT), rangés par classe de taille. Chaque thread garde quelques
+// tampons libres sans verrou ; au-delà ils passent au pool partagé, borné,
+// puis sont rendus au noyau.
+static void* pool_shared[POOL_CLASSES]; // Listes chaînées par le premier mot du tampon
+static long pool_shared_bytes = 0;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread void* pool_cache[POOL_CLASSES][POOL_THREAD_CACHE];
+static __thread int pool_cache_count[POOL_CLASSES];
+static __thread int pool_cache_registered = 0;
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+// Classe d'un tampon de size octets, -1 s'il dépasse la plus grande
+static int pool_class(int size) {
+    int class = 0;
+    while ((1 << (POOL_MIN_SHIFT + class)) < size) {
+        if (++class == POOL_CLASSES) {
+            return -1;
+        }
+    }
+    return class;
+}
+
+static int pool_bytes(int size) {
+    int class = pool_class(size);
+    return class < 0 ? (size + DIRECT_ALIGN - 1) / DIRECT_ALIGN * DIRECT_ALIGN : 1 << (POOL_MIN_SHIFT + class);
+}
+
+static void pool_release(void* buffer, int class) {
+    pthread_mutex_lock(&pool_lock);
+    long bytes = 1L << (POOL_MIN_SHIFT + class);
+    if (pool_shared_bytes + bytes <= POOL_SHARED_MAX) {
+        *(void**)buffer = pool_shared[class];
+        pool_shared[class] = buffer;
+        pool_shared_bytes += bytes;
+        buffer = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
+    if (buffer) {
+        munmap(buffer, bytes);
+    }
+}
+
+// À la fin d'un thread, son cache rejoint le pool partagé
+static void pool_drain_cache(void* unused) {
+    (void)unused;
+    for (int class = 0; class < POOL_CLASSES; class++) {
+        while (pool_cache_count[class] > 0) {
+            pool_release(pool_cache[class][--pool_cache_count[class]], class);
         }
-        current = &(*current)->next;
     }
 }
 
+static void pool_create_key(void) {
+    pthread_key_create(&pool_key, pool_drain_cache);
+}
 
+static void* pool_get(int size) {
+    int class = pool_class(size);
+    if (class >= 0 && pool_cache_count[class] > 0) {
+        return pool_cache[class][--pool_cache_count[class]];
+    }
+    void* buffer = NULL;
+    if (class >= 0) {
+        pthread_mutex_lock(&pool_lock);
+        buffer = pool_shared[class];
+        if (buffer) {
+            pool_shared[class] = *(void**)buffer;
+            pool_shared_bytes -= 1L << (POOL_MIN_SHIFT + class);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    if (!buffer) {
+        buffer = mmap(NULL, pool_bytes(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    return buffer == MAP_FAILED ? NULL : buffer;
+}
 
+static void pool_put(void* buffer, int size) {
+    int class = pool_class(size);
+    if (class < 0) {
+        munmap(buffer, pool_bytes(size));
+        return;
+    }
+    if (pool_cache_count[class] < POOL_THREAD_CACHE) {
+        if (!pool_cache_registered) {
+            pthread_once(&pool_key_once, pool_create_key);
+            pthread_setspecific(pool_key, &pool_cache_registered); // Non NULL : destructeur appelé
+            pool_cache_registered = 1;
+        }
+        pool_cache[class][pool_cache_count[class]++] = buffer;
+        return;
+    }
+    pool_release(buffer, class);
+}
 
+// Tampons du flux, pris dans le pool ; taille file->buffer_size
+static void* alloc_buffer(MYFILE* file) {
+    return pool_get(file->buffer_size);
+}
 
-MYFILE* mini_fopen(char* file, char mode) {
-    // Vérification si le nom du fichier est valide
-    if (file == NULL) {
+static void free_buffer(MYFILE* file, void* buffer) {
+    pool_put(buffer, file->buffer_size);
+}
+
+// Active ou retire O_DIRECT sur le descripteur
+static int set_direct(MYFILE* file, int on) {
+    int flags = fcntl(file->fd, F_GETFL);
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(file->fd, F_SETFL, on ? flags | O_DIRECT : flags & ~O_DIRECT);
+}
+
+// Retire O_DIRECT le temps d'un transfert non aligné, retourne 1 s'il faut
+// le rétablir ensuite avec set_direct(file, 1)
+static int suspend_direct(MYFILE* file) {
+    if (!file->direct) {
+        return 0;
+    }
+    int flags = fcntl(file->fd, F_GETFL);
+    if (flags == -1 || !(flags & O_DIRECT)) {
+        return 0;
+    }
+    return fcntl(file->fd, F_SETFL, flags & ~O_DIRECT) == 0;
+}
+
+static int flush_buffer(MYFILE* file); // mini_fflush sans la politique de durabilité
+
+// Flux O_DIRECT en écriture : vide le tampon et place le descripteur après
+// la fin non alignée conservée par flush_buffer, qui est abandonnée.
+// O_DIRECT est retiré si la position n'est plus alignée.
+static int direct_settle(MYFILE* file) {
+    if (!file->direct || !file->buffer_write || file->ind_write <= 0) {
+        return 0;
+    }
+    if (flush_buffer(file) == -1) {
+        return -1;
+    }
+    long end = file->offset + file->ind_write;
+    if (lseek(file->fd, end, SEEK_SET) == -1) {
+        return -1;
+    }
+    file->offset = end;
+    file->ind_write = 0;
+    if (end % DIRECT_ALIGN != 0) {
+        set_direct(file, 0);
+    }
+    return 0;
+}
+
+// Libère les tampons alloués par la bibliothèque (pas ceux fournis par l'appelant)
+static void release_buffers(MYFILE* file) {
+    if (!file->user_buffers) {
+        if (file->buffer_read) {
+            free_buffer(file, file->buffer_read);
+        }
+        if (file->buffer_write) {
+            free_buffer(file, file->buffer_write);
+        }
+    }
+    file->buffer_read = NULL;
+    file->buffer_write = NULL;
+    file->ind_read = -1;
+    file->end_read = -1;
+    file->ind_write = -1;
+    file->user_buffers = 0;
+    mark_clean(file);
+}
+
+// Verrou du flux : récursif, un seul échange atomique quand il est libre,
+// futex seulement en cas de contention (0 libre, 1 pris, 2 pris avec attente)
+static __thread char lock_token; // Son adresse identifie le thread appelant
+
+static void futex_wait(int* address, int value) {
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futex_wake(int* address) {
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void mini_flockfile(MYFILE* file) {
+    if (!file) {
+        return;
+    }
+    void* self = &lock_token;
+    if (__atomic_load_n(&file->lock_owner, __ATOMIC_RELAXED) == self) {
+        file->lock_count++;
+        return;
+    }
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&file->lock_state, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        // Contention : se déclarer en attente puis dormir jusqu'à la libération
+        while (__atomic_exchange_n(&file->lock_state, 2, __ATOMIC_ACQUIRE) != 0) {
+            futex_wait(&file->lock_state, 2);
+        }
+    }
+    __atomic_store_n(&file->lock_owner, self, __ATOMIC_RELAXED);
+    file->lock_count = 1;
+}
+
+int mini_ftrylockfile(MYFILE* file) {
+    if (!file) {
         errno = EINVAL;
-        return NULL;
+        return -1;
+    }
+    void* self = &lock_token;
+    if (__atomic_load_n(&file->lock_owner, __ATOMIC_RELAXED) == self) {
+        file->lock_count++;
+        return 0;
+    }
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&file->lock_state, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        errno = EBUSY;
+        return -1;
     }
+    __atomic_store_n(&file->lock_owner, self, __ATOMIC_RELAXED);
+    file->lock_count = 1;
+    return 0;
+}
+
+void mini_funlockfile(MYFILE* file) {
+    if (!file || --file->lock_count > 0) {
+        return;
+    }
+    __atomic_store_n(&file->lock_owner, NULL, __ATOMIC_RELAXED);
+    if (__atomic_exchange_n(&file->lock_state, 0, __ATOMIC_RELEASE) == 2) {
+        futex_wake(&file->lock_state);
+    }
+}
+
+// Avant main : taille de bloc des descripteurs standard, sortie tamponnée par
+// ligne seulement sur un terminal, et vidage de tous les flux si le
+// programme se termine par exit ou la fin de main plutôt que par mini_exit
+__attribute__((constructor)) static void std_streams_init(void) {
+    MYFILE* streams[3] = {&stdin_stream, &stdout_stream, &stderr_stream};
+    for (int i = 0; i < 3; i++) {
+        streams[i]->buffer_size = default_buffer_size(streams[i]->fd);
+        add_open_file(streams[i]);
+    }
+    stdout_stream.buffer_mode = isatty(STDOUT_FILENO) ? MINI_IOLBF : MINI_IOFBF;
+    atexit(mini_exit_flush);
+}
+
+static int is_std_stream(MYFILE* file) {
+    return file == &stdin_stream || file == &stdout_stream || file == &stderr_stream;
+}
+
+static int lz_open(MYFILE* file);   // compression par blocs, plus bas
+static int mapw_open(MYFILE* file); // écriture projetée, plus bas
 
+// Flux alloué et initialisé, sans descripteur ni tampon
+static MYFILE* new_stream(char mode) {
     // Allocation de mémoire pour le fichier
     MYFILE* File = (MYFILE*)mini_calloc(sizeof(MYFILE), 1);
     if (File == NULL) {
@@ -61,17 +414,68 @@ MYFILE* mini_fopen(char* file, char mode) {
     File->buffer_read = NULL;
     File->buffer_write = NULL;
     File->ind_read = -1;
+    File->end_read = -1;
     File->ind_write = -1;
+    File->mode = mode;
+    File->buffer_mode = MINI_IOFBF;
+    File->user_buffers = 0;
+    File->map = NULL;
+    File->map_len = 0;
+    File->map_pos = 0;
+    File->readahead = NULL;
+    mini_strbuf_init(&File->line);
+    File->lock_state = 0;
+    File->lock_count = 0;
+    File->lock_owner = NULL;
+    File->dirty = 0;
+    File->dirty_prev = NULL;
+    File->dirty_next = NULL;
+    File->direct = 0;
+    File->lz = NULL;
+    File->sync = NULL;
+    File->mapw = NULL;
+    File->mem = NULL;
+    File->handed = 0;
+    return File;
+}
+
+MYFILE* mini_fopen(char* file, char mode) {
+    // Vérification si le nom du fichier est valide
+    if (file == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    MYFILE* File = new_stream(mode);
+    if (File == NULL) {
+        return NULL;
+    }
 
     // Définition des flags d'ouverture du fichier en fonction du mode
     int flags;
     switch (mode) {
         case 'r':
+        case 'm':
             flags = O_RDONLY;
             break;
+        case 'd':
+            flags = O_RDONLY | O_DIRECT;
+            break;
         case 'w':
             flags = O_WRONLY | O_CREAT | O_TRUNC;
             break;
+        case 'D':
+            flags = O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT;
+            break;
+        case 'z':
+            flags = O_RDONLY;
+            break;
+        case 'Z':
+            flags = O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+        case 'M':
+            flags = O_RDWR | O_CREAT | O_TRUNC; // PROT_WRITE exige un descripteur lisible
+            break;
         case 'b':
             flags = O_RDWR | O_CREAT;
             break;
@@ -86,12 +490,67 @@ MYFILE* mini_fopen(char* file, char mode) {
 
     // Ouverture du fichier
     File->fd = open(file, flags, 0664);  // Permissions 0664
+    if (File->fd == -1 && (flags & O_DIRECT) && errno == EINVAL) {
+        // Système de fichiers sans O_DIRECT (tmpfs...) : accès tamponné classique
+        flags &= ~O_DIRECT;
+        File->fd = open(file, flags, 0664);
+    }
     if (File->fd == -1) {
         // Si l'ouverture échoue, libère la mémoire et retourne NULL
         mini_free(File);
         errno = errno;  // Conserve l'erreur d'open
         return NULL;
     }
+    File->buffer_size = default_buffer_size(File->fd);
+    // O_DIRECT : tampons alignés et assez gros pour amortir l'absence de cache
+    File->direct = (flags & O_DIRECT) != 0;
+    if (File->direct) {
+        File->buffer_size = (File->buffer_size + DIRECT_ALIGN - 1) / DIRECT_ALIGN * DIRECT_ALIGN;
+        if (File->buffer_size < DIRECT_BUFFER) {
+            File->buffer_size = DIRECT_BUFFER;
+        }
+    }
+    // En ajout, chaque écriture a lieu en fin de fichier
+    File->offset = 0;
+    if (mode == 'a') {
+        off_t end = lseek(File->fd, 0, SEEK_END);
+        File->offset = end > 0 ? end : 0;
+    }
+    File->read_base = 0;
+
+    // Mode 'm' : projection du fichier en mémoire, les lectures deviennent de
+    // simples copies depuis la projection. Les tubes et fichiers spéciaux
+    // (ou vides) restent en lecture tamponnée classique.
+    if (mode == 'm') {
+        struct stat info;
+        if (fstat(File->fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, File->fd, 0);
+            if (map != MAP_FAILED) {
+                madvise(map, info.st_size, MADV_SEQUENTIAL);
+                File->map = (char*)map;
+                File->map_len = info.st_size;
+            }
+        }
+    }
+
+    // Mode 'M' : écriture par copie dans une fenêtre projetée ; comme pour
+    // 'm', un fichier spécial reste en écriture tamponnée classique
+    if (mode == 'M' && mapw_open(File) == -1) {
+        int error = errno;
+        close(File->fd);
+        mini_free(File);
+        errno = error;
+        return NULL;
+    }
+
+    // Modes 'z' et 'Z' : flux compressé par blocs
+    if ((mode == 'z' || mode == 'Z') && lz_open(File) == -1) {
+        int error = errno;
+        close(File->fd);
+        mini_free(File);
+        errno = error;
+        return NULL;
+    }
 
     // Ajout du fichier à la liste des fichiers ouverts
     add_open_file(File);
@@ -99,12 +558,79 @@ MYFILE* mini_fopen(char* file, char mode) {
     return File;
 }
 
+static int setvbuf_unlocked(MYFILE* file, char* buf, int mode, int size) {
+    if (!file || (mode != MINI_IOFBF && mode != MINI_IOLBF && mode != MINI_IONBF)
+        || size < 0 || (buf != NULL && size == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Des octets lus mais pas encore consommés seraient perdus, et les
+    // tampons de la lecture anticipée appartiennent à son thread
+    if (file->ind_read < file->end_read || file->readahead) {
+        errno = EBUSY;
+        return -1;
+    }
+    // O_DIRECT : tampon obligatoire, aligné et alloué par la bibliothèque ;
+    // flux compressé : le tampon est le bloc, sa taille est fixée par le format ;
+    // écriture projetée et flux en mémoire : pas de tampon
+    if ((file->direct && (buf != NULL || mode == MINI_IONBF || size % DIRECT_ALIGN != 0)) || file->lz || file->mapw
+        || file->mem) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flush_buffer(file) == -1 || direct_settle(file) == -1) {
+        return -1;
+    }
+    release_buffers(file);
+
+    file->buffer_mode = mode;
+    if (size > 0) {
+        file->buffer_size = size;
+    }
+    if (buf != NULL && mode != MINI_IONBF) {
+        // Le tampon fourni sert à la lecture, à l'écriture ou est partagé
+        // en deux moitiés pour un fichier ouvert en lecture/écriture
+        file->user_buffers = 1;
+        if (file->mode == 'r') {
+            file->buffer_read = buf;
+        } else if (file->mode == 'b') {
+            file->buffer_size = size / 2;
+            file->buffer_read = buf;
+            file->buffer_write = buf + file->buffer_size;
+        } else {
+            file->buffer_write = buf;
+        }
+        if (file->buffer_read) {
+            file->ind_read = 0;
+            file->end_read = 0;
+        }
+        if (file->buffer_write) {
+            file->ind_write = 0;
+        }
+    }
+    return 0;
+}
+
+int mini_setvbuf(MYFILE* file, char* buf, int mode, int size) {
+    mini_flockfile(file);
+    int result = setvbuf_unlocked(file, buf, mode, size);
+    mini_funlockfile(file);
+    return result;
+}
+
 
 void* mini_memcpy(void* dest, const void* src, int n) {
     char* d = (char*)dest;
     const char* s = (const char*)src;
+    int i = 0;
 
-    for (int i = 0; i < n; i++) {
+#ifdef __SSE2__
+    // Copie par blocs de 16 octets, le reste octet par octet
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(d + i), _mm_loadu_si128((const __m128i*)(s + i)));
+    }
+#endif
+    for (; i < n; i++) {
         d[i] = s[i];
     }
 
@@ -140,130 +666,1847 @@ void* mini_memmove(void* dest, const void* src, int n) {
     return dest;
 }
 
-int mini_fread(void* buffer, int size_element, int number_element, MYFILE* file) {
-    if (!buffer || !file || size_element <= 0 || number_element <= 0) {
-        errno = EINVAL; // Paramètres invalides
-        mini_perror("Invalid parameters");
-        return -1;
-    }
-
-    int total_size = size_element * number_element; // Taille totale à lire
-    int bytes_read = 0;                             // Nombre total de caractères lus
-    char* user_buffer = (char*)buffer;
+// Statistiques : horloge monotone en nanosecondes et enregistrement d'un
+// appel système (stats NULL : appel non compté)
+static long stats_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
 
-    // Allocation du tampon de lecture si nécessaire
-    if (!file->buffer_read) {
-        file->buffer_read = mini_calloc(IOBUFFER_SIZE, 1);
-        if (!file->buffer_read) {
-            errno = ENOMEM;
-            mini_perror("Failed to allocate buffer_read");
-            return -1;
-        }
-        file->ind_read = 0; // Initialisation de l'indicateur
+static void stats_latency(long* histogram, long ns) {
+    int bucket = 0;
+    while (ns > 1 && bucket < MINI_STATS_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
     }
+    histogram[bucket]++;
+}
 
-    while (bytes_read < total_size) {
-        // Si l'index de lecture est à 0, lire un nouveau bloc depuis le fichier
-        if (file->ind_read == 0) {
-            int result = read(file->fd, file->buffer_read, IOBUFFER_SIZE);
-            if (result == 0) {
-                // Fin de fichier atteinte
-                break;
-            } else if (result < 0) {
-                // Gestion des erreurs de lecture
-                mini_perror("Error reading file");
-                return -1;
-            }
-            file->ind_read = result; // Met à jour la taille des données disponibles dans le tampon
-        }
-
-        // Calculer combien de données copier du tampon
-        int bytes_to_copy = total_size - bytes_read;
-        if (bytes_to_copy > file->ind_read) {
-            bytes_to_copy = file->ind_read;
-        }
-
-        // Copier les données du tampon vers le buffer utilisateur
-        mini_memcpy(user_buffer + bytes_read, file->buffer_read, bytes_to_copy);
-
-        // Mettre à jour les compteurs et les indices
-        bytes_read += bytes_to_copy;
-        file->ind_read -= bytes_to_copy;
-
-        // Décaler les données restantes dans le tampon
-        if (file->ind_read > 0) {
-            mini_memmove(file->buffer_read,
-                         (char*)file->buffer_read + bytes_to_copy,
-                         file->ind_read);
-        }
+static void stats_read(mini_iostats* stats, long start, long requested, long result) {
+    if (!stats) {
+        return;
     }
-
-    return bytes_read; // Retourne le nombre de caractères lus
+    stats->read_calls++;
+    if (result > 0) {
+        stats->bytes_read += result;
+    }
+    if (result >= 0 && result < requested) {
+        stats->short_reads++;
+    }
+    stats_latency(stats->read_latency, stats_clock() - start);
 }
 
+static void stats_write(mini_iostats* stats, long start, long result) {
+    if (!stats) {
+        return;
+    }
+    stats->write_calls++;
+    if (result > 0) {
+        stats->bytes_written += result;
+    }
+    stats_latency(stats->write_latency, stats_clock() - start);
+}
 
-
-int mini_fwrite(void* buffer, int size_element, int number_element, MYFILE* file) {
-    if (!buffer || !file || size_element <= 0 || number_element <= 0) {
-        errno = EINVAL; // Paramètres invalides
-        return -1;
+// Appel système d'écriture d'un flux : compteurs, et octets confiés au
+// noyau pour la politique de durabilité
+static void note_write(MYFILE* file, long start, long result) {
+    stats_write(&file->stats, start, result);
+    if (result > 0) {
+        file->handed += result;
     }
+}
 
-    int total_size = size_element * number_element; // Taille totale à écrire
-    int bytes_written = 0; // Nombre total d'octets effectivement écrits
-    char* user_buffer = (char*)buffer;
+// read() qui tient à jour la position connue du descripteur, relancé
+// s'il est interrompu par un signal
+static int read_fd(MYFILE* file, void* dest, int len) {
+    int result;
+    do {
+        long start = stats_clock();
+        result = read(file->fd, dest, len);
+        stats_read(&file->stats, start, len, result);
+    } while (result == -1 && errno == EINTR);
+    if (result > 0) {
+        file->offset += result;
+    }
+    return result;
+}
 
-    // Allocation du tampon d'écriture si nécessaire
-    if (!file->buffer_write) {
-        file->buffer_write = mini_calloc(IOBUFFER_SIZE, 1);
-        if (!file->buffer_write) {
-            errno = ENOMEM; // Échec d'allocation mémoire
+// Écrit len octets en relançant write() après une écriture partielle ou
+// une interruption par un signal
+static int write_all(MYFILE* file, const char* data, int len) {
+    int done = 0;
+    while (done < len) {
+        long start = stats_clock();
+        int result = write(file->fd, data + done, len - done);
+        note_write(file, start, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
             return -1;
         }
-        file->ind_write = 0; // Initialisation de l'indice d'écriture
+        file->offset += result;
+        done += result;
     }
+    return done;
+}
 
-    while (bytes_written < total_size) {
-        // Calcul de l'espace disponible dans le tampon
-        int available_space = IOBUFFER_SIZE - file->ind_write;
+// Lecture anticipée : un thread remplit le tampon « de fond » pendant que
+// l'appelant consomme le tampon exposé dans buffer_read ; les deux sont
+// échangés à chaque recharge. Le thread est le seul à lire le descripteur
+// tant que la lecture anticipée est active.
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int threaded;       // 0 : pas de thread, seulement posix_fadvise
+    char* buffers[2];
+    int front;          // indice du tampon exposé dans buffer_read
+    int back_len;       // octets lus dans le tampon de fond, -1 en cas d'erreur
+    int back_errno;
+    long back_ns;       // durée du read() du tampon de fond
+    long back_offset;   // position dans le fichier du tampon de fond
+    long next_offset;   // position du descripteur pour le thread
+    int wanted;         // le thread doit remplir le tampon de fond
+    int busy;           // lecture en cours dans le thread
+    int ready;          // tampon de fond rempli, pas encore échangé
+    int stop;
+} ReadAhead;
 
-        // Calculer combien d'octets on peut écrire dans le tampon
-        int bytes_to_copy = total_size - bytes_written;
-        if (bytes_to_copy > available_space) {
-            bytes_to_copy = available_space;
-        }
+// Annonce au noyau les prochains blocs pour qu'il les charge en avance
+static void readahead_advise(MYFILE* file, long offset) {
+    posix_fadvise(file->fd, offset, (off_t)file->buffer_size * READAHEAD_WINDOW, POSIX_FADV_WILLNEED);
+}
 
-        // Copier les données dans le tampon d'écriture
-        mini_memcpy((char*)file->buffer_write + file->ind_write, 
-                    user_buffer + bytes_written, 
-                    bytes_to_copy);
+static void* readahead_thread(void* arg) {
+    MYFILE* file = (MYFILE*)arg;
+    ReadAhead* ra = (ReadAhead*)file->readahead;
+    pthread_mutex_lock(&ra->lock);
+    while (1) {
+        while (!ra->stop && !ra->wanted) {
+            pthread_cond_wait(&ra->cond, &ra->lock);
+        }
+        if (ra->stop) {
+            break;
+        }
+        ra->wanted = 0;
+        ra->busy = 1;
+        long offset = ra->next_offset;
+        char* dest = ra->buffers[ra->front ^ 1];
+        pthread_mutex_unlock(&ra->lock);
 
-        file->ind_write += bytes_to_copy;
-        bytes_written += bytes_to_copy;
+        readahead_advise(file, offset + file->buffer_size);
+        int result;
+        long start = stats_clock();
+        do {
+            result = read(file->fd, dest, file->buffer_size);
+        } while (result == -1 && errno == EINTR);
+        int error = errno;
+        long ns = stats_clock() - start;
 
-        // Si le tampon est plein, déclencher une écriture
-        if (file->ind_write == IOBUFFER_SIZE) {
-            int result = write(file->fd, file->buffer_write, IOBUFFER_SIZE);
-            if (result == -1) {
-                mini_perror("Error writing to file");
-                return -1; // Échec d'écriture
-            }
-            file->ind_write = 0; // Réinitialiser l'indicateur d'écriture
+        pthread_mutex_lock(&ra->lock);
+        ra->busy = 0;
+        ra->back_len = result;
+        ra->back_errno = error;
+        ra->back_ns = ns;
+        ra->back_offset = offset;
+        if (result > 0) {
+            ra->next_offset += result;
         }
+        ra->ready = 1;
+        pthread_cond_broadcast(&ra->cond);
     }
-
-    return bytes_written; // Retourne le nombre d'octets écrits
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
 }
 
-
-int mini_fflush(MYFILE* file) {
-    if (!file || !file->buffer_write || file->ind_write <= 0) {
-        // Aucun fichier valide ou rien à écrire
-        return 0;
+// Recharge buffer_read avec le bloc suivant, retourne sa taille (0 en fin de fichier)
+static int readahead_fill(MYFILE* file) {
+    ReadAhead* ra = (ReadAhead*)file->readahead;
+    if (!ra->threaded) {
+        readahead_advise(file, file->offset + file->buffer_size);
+        file->read_base = file->offset;
+        return read_fd(file, file->buffer_read, file->buffer_size);
+    }
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->ready) {
+        pthread_cond_wait(&ra->cond, &ra->lock);
+    }
+    ra->ready = 0;
+    int result = ra->back_len;
+    // Compté ici, par le détenteur du flux, avec la durée mesurée par le thread
+    stats_read(&file->stats, stats_clock() - ra->back_ns, file->buffer_size, result);
+    if (result > 0) {
+        // Le bloc lu passe devant, l'ancien tampon repart se remplir
+        ra->front ^= 1;
+        file->buffer_read = ra->buffers[ra->front];
+        file->read_base = ra->back_offset;
+        file->offset = ra->back_offset + result;
+    } else if (result == -1) {
+        errno = ra->back_errno;
+    }
+    // Fin de fichier ou erreur : l'appel suivant relira à la même position,
+    // comme un read() de plus le ferait
+    ra->wanted = 1;
+    pthread_cond_broadcast(&ra->cond);
+    pthread_mutex_unlock(&ra->lock);
+    return result;
+}
+
+// Repart de target après un déplacement hors du tampon courant
+static int readahead_seek(MYFILE* file, long target) {
+    ReadAhead* ra = (ReadAhead*)file->readahead;
+    if (!ra->threaded) {
+        return lseek(file->fd, target, SEEK_SET) == -1 ? -1 : 0;
+    }
+    pthread_mutex_lock(&ra->lock);
+    ra->wanted = 0;
+    while (ra->busy) {
+        pthread_cond_wait(&ra->cond, &ra->lock);
+    }
+    int result = lseek(file->fd, target, SEEK_SET) == -1 ? -1 : 0;
+    if (result == 0) {
+        ra->next_offset = target;
+    }
+    // Relancer la lecture du premier bloc, même après une erreur (l'appel
+    // suivant à mini_fread verra alors la position inchangée)
+    ra->ready = 0;
+    ra->wanted = 1;
+    pthread_cond_broadcast(&ra->cond);
+    pthread_mutex_unlock(&ra->lock);
+    return result;
+}
+
+// Arrête le thread ; le tampon exposé reste celui du flux, le bloc lu
+// d'avance est rendu au fichier en reculant le descripteur
+static void readahead_stop(MYFILE* file) {
+    ReadAhead* ra = (ReadAhead*)file->readahead;
+    if (ra->threaded) {
+        pthread_mutex_lock(&ra->lock);
+        ra->stop = 1;
+        pthread_cond_broadcast(&ra->cond);
+        pthread_mutex_unlock(&ra->lock);
+        pthread_join(ra->thread, NULL);
+        pthread_mutex_destroy(&ra->lock);
+        pthread_cond_destroy(&ra->cond);
+        if (ra->next_offset != file->offset) {
+            lseek(file->fd, file->offset, SEEK_SET); // Sans effet sur un tube
+        }
+        free_buffer(file, ra->buffers[ra->front ^ 1]);
+    }
+    mini_free(ra);
+    file->readahead = NULL;
+}
+
+static int freadahead_unlocked(MYFILE* file, int enable) {
+    if (!file || (file->mode != 'r' && file->mode != 'm')) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!enable) {
+        if (file->readahead) {
+            readahead_stop(file);
+        }
+        return 0;
+    }
+    // Fichier projeté : madvise(MADV_SEQUENTIAL) joue déjà ce rôle
+    if (file->readahead || file->map) {
+        return 0;
+    }
+    // Comme pour mini_setvbuf, les octets non consommés seraient perdus
+    if (file->ind_read < file->end_read) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    ReadAhead* ra = (ReadAhead*)mini_calloc(sizeof(ReadAhead), 1);
+    if (!ra) {
+        errno = ENOMEM;
+        return -1;
+    }
+    release_buffers(file);
+    if (file->buffer_size < READAHEAD_BLOCK) {
+        file->buffer_size = READAHEAD_BLOCK; // Un échange par bloc : des blocs assez gros
+    }
+    ra->buffers[0] = (char*)alloc_buffer(file);
+    ra->buffers[1] = ra->buffers[0] ? (char*)alloc_buffer(file) : NULL;
+    if (!ra->buffers[1]) {
+        if (ra->buffers[0]) {
+            free_buffer(file, ra->buffers[0]);
+        }
+        mini_free(ra);
+        errno = ENOMEM;
+        return -1;
+    }
+    file->readahead = ra;
+    file->buffer_read = ra->buffers[0];
+    file->ind_read = 0;
+    file->end_read = 0;
+    posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    ra->next_offset = file->offset;
+    ra->wanted = 1;
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->cond, NULL);
+    if (pthread_create(&ra->thread, NULL, readahead_thread, file) == 0) {
+        ra->threaded = 1;
+    } else {
+        // Pas de thread disponible : simple annonce des blocs à venir
+        pthread_mutex_destroy(&ra->lock);
+        pthread_cond_destroy(&ra->cond);
+        free_buffer(file, ra->buffers[1]);
+    }
+    return 0;
+}
+
+int mini_freadahead(MYFILE* file, int enable) {
+    mini_flockfile(file);
+    int result = freadahead_unlocked(file, enable);
+    mini_funlockfile(file);
+    return result;
+}
+
+// 1 si tous les transferts doivent passer par le tampon du flux : il est
+// rempli par un thread, aligné pour O_DIRECT, compressé bloc par bloc ou
+// remplacé par une projection (mode 'M') ou par la mémoire (mini_fmemopen)
+static int buffered_only(MYFILE* file) {
+    return file->readahead || file->direct || file->lz || file->mapw || file->mem;
+}
+
+// Compression par blocs (modes 'z' et 'Z'). Format du fichier :
+//   en-tête   "MINILZ01", taille de bloc (int), 4 octets réservés
+//   blocs     taille compressée (bit de poids fort : stocké tel quel),
+//             taille décompressée, puis les données
+//   fin       bloc {0, 0}, l'index (position compressée, position
+//             décompressée) de chaque bloc, le nombre de blocs et "MINILZIX"
+// L'index permet de se déplacer et de lire les blocs indépendamment ; sans
+// lui (fichier non fermé), il est reconstruit en parcourant les en-têtes.
+typedef struct {
+    long file_pos;      // position du descripteur dans le fichier compressé
+    char* packed;       // bloc compressé (en-tête compris)
+    int packed_size;
+    long* index;        // deux entrées par bloc
+    int blocks;
+    int index_capacity;
+} LzStream;
+
+static int lz_index_add(LzStream* lz, long packed_pos, long raw_pos) {
+    if (lz->blocks == lz->index_capacity) {
+        int capacity = lz->index_capacity ? lz->index_capacity * 2 : 64;
+        long* index = (long*)mini_calloc(sizeof(long) * 2, capacity);
+        if (!index) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (lz->index) {
+            mini_memcpy(index, lz->index, lz->blocks * 2 * (int)sizeof(long));
+            mini_free(lz->index);
+        }
+        lz->index = index;
+        lz->index_capacity = capacity;
+    }
+    lz->index[2 * lz->blocks] = packed_pos;
+    lz->index[2 * lz->blocks + 1] = raw_pos;
+    lz->blocks++;
+    return 0;
+}
+
+// pread/write complets, sans toucher à la position décompressée file->offset
+static int pread_all(int fd, void* dest, int len, long offset, mini_iostats* stats) {
+    int done = 0;
+    while (done < len) {
+        long start = stats_clock();
+        int result = pread(fd, (char*)dest + done, len - done, offset + done);
+        stats_read(stats, start, len - done, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return result < 0 ? -1 : done;
+        }
+        done += result;
+    }
+    return done;
+}
+
+static int write_fd_all(MYFILE* file, const void* data, int len) {
+    int done = 0;
+    while (done < len) {
+        long start = stats_clock();
+        int result = write(file->fd, (const char*)data + done, len - done);
+        note_write(file, start, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            return -1;
+        }
+        done += result;
+    }
+    return done;
+}
+
+static int lz_ensure_packed(LzStream* lz, int block_size) {
+    int needed = 8 + mini_lz_bound(block_size);
+    if (lz->packed_size >= needed) {
+        return 0;
+    }
+    if (lz->packed) {
+        mini_free(lz->packed);
+    }
+    lz->packed = (char*)mini_calloc(needed, 1);
+    lz->packed_size = lz->packed ? needed : 0;
+    if (!lz->packed) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static void lz_free(MYFILE* file) {
+    LzStream* lz = (LzStream*)file->lz;
+    if (lz->packed) {
+        mini_free(lz->packed);
+    }
+    if (lz->index) {
+        mini_free(lz->index);
+    }
+    mini_free(lz);
+    file->lz = NULL;
+}
+
+// Lit l'index en fin de fichier, ou le reconstruit depuis les en-têtes
+static int lz_load_index(MYFILE* file) {
+    LzStream* lz = (LzStream*)file->lz;
+    struct stat info;
+    if (fstat(file->fd, &info) == -1) {
+        return -1;
+    }
+    long trailer[2];
+    if (info.st_size >= LZ_HEADER + 8 + 16
+        && pread_all(file->fd, trailer, 16, info.st_size - 16, &file->stats) == 16
+        && mini_memcmp(&trailer[1], "MINILZIX", 8) == 0
+        && trailer[0] >= 0 && LZ_HEADER + 8 + trailer[0] * 16 + 16 <= info.st_size) {
+        long count = trailer[0];
+        long start = info.st_size - 16 - count * 16;
+        for (long i = 0; i < count; i++) {
+            long entry[2];
+            if (pread_all(file->fd, entry, 16, start + i * 16, &file->stats) != 16 || lz_index_add(lz, entry[0], entry[1]) == -1) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    long pos = LZ_HEADER, raw = 0;
+    unsigned int header[2];
+    while (pread_all(file->fd, header, 8, pos, &file->stats) == 8 && (header[0] != 0 || header[1] != 0)) {
+        if (lz_index_add(lz, pos, raw) == -1) {
+            return -1;
+        }
+        pos += 8 + (header[0] & ~LZ_STORED);
+        raw += header[1];
+    }
+    return 0;
+}
+
+// Prépare un flux 'z' (lecture de l'en-tête et de l'index) ou 'Z'
+// (écriture de l'en-tête) ; les tampons du flux font un bloc
+static int lz_open(MYFILE* file) {
+    LzStream* lz = (LzStream*)mini_calloc(sizeof(LzStream), 1);
+    if (!lz) {
+        errno = ENOMEM;
+        return -1;
+    }
+    file->lz = lz;
+    char header[LZ_HEADER] = "MINILZ01";
+    int block_size = LZ_BLOCK;
+    if (file->mode == 'Z') {
+        mini_memcpy(header + 8, &block_size, sizeof(int));
+        if (write_fd_all(file, header, LZ_HEADER) == -1) {
+            lz_free(file);
+            return -1;
+        }
+    } else {
+        if (pread_all(file->fd, header, LZ_HEADER, 0, &file->stats) != LZ_HEADER || mini_memcmp(header, "MINILZ01", 8) != 0) {
+            lz_free(file);
+            errno = EINVAL; // Pas un fichier compressé par mini_io
+            return -1;
+        }
+        mini_memcpy(&block_size, header + 8, sizeof(int));
+        if (block_size <= 0 || lz_load_index(file) == -1 || lseek(file->fd, LZ_HEADER, SEEK_SET) == -1) {
+            lz_free(file);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    lz->file_pos = LZ_HEADER;
+    file->buffer_size = block_size;
+    return 0;
+}
+
+// Compresse et écrit un bloc de len octets (un tampon plein, ou moins au vidage)
+static int lz_write_block(MYFILE* file, const char* data, int len) {
+    LzStream* lz = (LzStream*)file->lz;
+    if (lz_ensure_packed(lz, file->buffer_size) == -1) {
+        return -1;
+    }
+    unsigned int header[2];
+    int packed = mini_lz_compress(data, len, lz->packed + 8, lz->packed_size - 8);
+    if (packed < 0 || packed >= len) {
+        mini_memcpy(lz->packed + 8, data, len); // Incompressible : stocké tel quel
+        packed = len;
+        header[0] = (unsigned int)len | LZ_STORED;
+    } else {
+        header[0] = (unsigned int)packed;
+    }
+    header[1] = (unsigned int)len;
+    mini_memcpy(lz->packed, header, 8);
+    if (lz_index_add(lz, lz->file_pos, file->offset) == -1 || write_fd_all(file, lz->packed, 8 + packed) == -1) {
+        return -1;
+    }
+    lz->file_pos += 8 + packed;
+    file->offset += len;
+    return len;
+}
+
+// Lit et décompresse le bloc stocké à packed_pos dans dest ; retourne sa
+// taille décompressée, 0 en fin de blocs. Ne dépend pas de la position du
+// descripteur : plusieurs threads peuvent lire des blocs différents (sans
+// compter leurs lectures : stats NULL).
+static int lz_read_block_at(MYFILE* file, long packed_pos, char* scratch, int scratch_size,
+                            char* dest, int capacity, long* next_pos, mini_iostats* stats) {
+    unsigned int header[2];
+    int got = pread_all(file->fd, header, 8, packed_pos, stats);
+    if (got < 0) {
+        return -1;
+    }
+    if (got < 8 || (header[0] == 0 && header[1] == 0)) {
+        return 0;
+    }
+    int packed = (int)(header[0] & ~LZ_STORED);
+    int raw = (int)header[1];
+    if (packed > scratch_size || raw > capacity) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (pread_all(file->fd, scratch, packed, packed_pos + 8, stats) != packed) {
+        errno = EIO;
+        return -1;
+    }
+    if (header[0] & LZ_STORED) {
+        if (packed != raw) {
+            errno = EINVAL;
+            return -1;
+        }
+        mini_memcpy(dest, scratch, raw);
+    } else if (mini_lz_decompress(scratch, packed, dest, capacity) != raw) {
+        errno = EINVAL; // Bloc corrompu
+        return -1;
+    }
+    if (next_pos) {
+        *next_pos = packed_pos + 8 + packed;
+    }
+    return raw;
+}
+
+// Longueur décompressée d'un flux 'z' : position du dernier bloc plus sa
+// taille décompressée, lue dans son en-tête
+static long lz_length(MYFILE* file) {
+    LzStream* lz = (LzStream*)file->lz;
+    if (lz->blocks == 0) {
+        return 0;
+    }
+    unsigned int header[2];
+    long last = lz->blocks - 1;
+    if (pread_all(file->fd, header, 8, lz->index[2 * last], &file->stats) != 8) {
+        errno = EIO;
+        return -1;
+    }
+    return lz->index[2 * last + 1] + header[1];
+}
+
+static int lz_read_block(MYFILE* file, char* dest) {
+    LzStream* lz = (LzStream*)file->lz;
+    if (lz_ensure_packed(lz, file->buffer_size) == -1) {
+        return -1;
+    }
+    long next_pos;
+    int result = lz_read_block_at(file, lz->file_pos, lz->packed, lz->packed_size, dest, file->buffer_size, &next_pos, &file->stats);
+    if (result > 0) {
+        lz->file_pos = next_pos;
+        file->offset += result;
+    }
+    return result;
+}
+
+// Termine un flux 'Z' : marque de fin, index et signature
+static int lz_finish(MYFILE* file) {
+    LzStream* lz = (LzStream*)file->lz;
+    unsigned int end[2] = {0, 0};
+    long trailer[2] = {lz->blocks, 0};
+    mini_memcpy(&trailer[1], "MINILZIX", 8);
+    if (write_fd_all(file, end, 8) == -1
+        || (lz->blocks > 0 && write_fd_all(file, lz->index, lz->blocks * 16) == -1)
+        || write_fd_all(file, trailer, 16) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+int mini_fzblocks(MYFILE* file) {
+    if (!file || !file->lz || file->mode != 'z') {
+        errno = EINVAL;
+        return -1;
+    }
+    return ((LzStream*)file->lz)->blocks;
+}
+
+int mini_fzread_block(MYFILE* file, int block, void* dest, int capacity) {
+    if (!file || !file->lz || file->mode != 'z' || !dest || block < 0
+        || block >= ((LzStream*)file->lz)->blocks) {
+        errno = EINVAL;
+        return -1;
+    }
+    LzStream* lz = (LzStream*)file->lz;
+    int scratch_size = 8 + mini_lz_bound(file->buffer_size);
+    char* scratch = (char*)mini_calloc(scratch_size, 1);
+    if (!scratch) {
+        errno = ENOMEM;
+        return -1;
+    }
+    int result = lz_read_block_at(file, lz->index[2 * block], scratch, scratch_size, (char*)dest, capacity, NULL, NULL);
+    mini_free(scratch);
+    return result;
+}
+
+// Écriture projetée (mode 'M') : les octets sont copiés dans une fenêtre
+// MAP_SHARED qui glisse le long du fichier. Le fichier est agrandi par
+// tranches de MAPW_EXTENT (ftruncate) avant d'être touché, puis ramené à
+// sa longueur logique par mini_fclose (ou le vidage de fin de programme) :
+// mini_fflush ne fait que signaler au noyau la plage écrite, sans tronquer.
+typedef struct {
+    char* window;
+    long base;          // position dans le fichier de window[0]
+    long window_len;    // 0 : pas de fenêtre
+    long pos;           // position d'écriture
+    long length;        // longueur logique (plus grande position écrite)
+    long extent;        // taille réelle du fichier
+    long dirty_start;   // plage écrite depuis le dernier mini_fflush,
+    long dirty_end;     // vide si dirty_start == dirty_end
+} MapWriter;
+
+static int mapw_open(MYFILE* file) {
+    struct stat info;
+    if (fstat(file->fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+        return 0;
+    }
+    MapWriter* mw = (MapWriter*)mini_calloc(sizeof(MapWriter), 1);
+    if (!mw) {
+        errno = ENOMEM;
+        return -1;
+    }
+    file->mapw = mw;
+    return 0;
+}
+
+// Agrandit le fichier pour que [0, end) puisse être écrit par la projection
+static int mapw_reserve(MYFILE* file, long end) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    if (end <= mw->extent) {
+        return 0;
+    }
+    long extent = (end + MAPW_EXTENT - 1) / MAPW_EXTENT * MAPW_EXTENT;
+    // Agrandissement creux : fallocate réserverait les blocs mais coûte leur
+    // conversion à l'écriture (débit divisé par 1,5). Un disque plein
+    // donnerait SIGBUS à la première écriture dans la projection : l'espace
+    // libre est vérifié ici pour échouer proprement dans le cas courant. La
+    // tranche reste creuse : seuls les octets à écrire au-delà de la longueur
+    // logique prendront des blocs.
+    struct statfs fs;
+    if (fstatfs(file->fd, &fs) == 0 && (long)fs.f_bavail * (long)fs.f_bsize < end - mw->length) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (ftruncate(file->fd, extent) == -1) {
+        return -1;
+    }
+    mw->extent = extent;
+    return 0;
+}
+
+// Place la fenêtre sur la tranche alignée qui contient pos
+static int mapw_slide(MYFILE* file, long pos) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    if (mw->window_len > 0 && pos >= mw->base && pos < mw->base + mw->window_len) {
+        return 0;
+    }
+    if (mw->window_len > 0) {
+        munmap(mw->window, mw->window_len);
+        mw->window_len = 0;
+    }
+    long base = pos / MAPW_WINDOW * MAPW_WINDOW;
+    void* window = mmap(NULL, MAPW_WINDOW, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, base);
+    if (window == MAP_FAILED) {
+        return -1;
+    }
+    mw->window = (char*)window;
+    mw->base = base;
+    mw->window_len = MAPW_WINDOW;
+    return 0;
+}
+
+static int mapw_write(MYFILE* file, const char* data, int len) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    if (mapw_reserve(file, mw->pos + len) == -1) {
+        return -1;
+    }
+    if (mw->dirty_start == mw->dirty_end) {
+        mw->dirty_start = mw->dirty_end = mw->pos;
+    }
+    if (mw->pos < mw->dirty_start) {
+        mw->dirty_start = mw->pos;
+    }
+    if (mw->pos + len > mw->dirty_end) {
+        mw->dirty_end = mw->pos + len;
+    }
+    int done = 0;
+    while (done < len) {
+        if (mapw_slide(file, mw->pos) == -1) {
+            return -1;
+        }
+        long room = mw->base + mw->window_len - mw->pos;
+        int n = len - done < room ? len - done : (int)room;
+        mini_memcpy(mw->window + (mw->pos - mw->base), data + done, n);
+        mw->pos += n;
+        done += n;
+    }
+    if (mw->pos > mw->length) {
+        mw->length = mw->pos;
+    }
+    file->stats.bytes_written += len;
+    file->handed += len; // Suivi de durabilité (mini_fsetsync)
+    mark_dirty(file);
+    return len;
+}
+
+// mini_fflush : la plage écrite depuis le dernier vidage est signalée au
+// noyau (msync asynchrone) pour la partie encore projetée ; les fenêtres
+// déjà démontées lui ont été rendues par munmap. Le flux reste dans la liste
+// des flux à vider tant que le fichier n'est pas ramené à sa longueur.
+static int mapw_flush(MYFILE* file) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    long start = mw->dirty_start > mw->base ? mw->dirty_start : mw->base;
+    long end = mw->dirty_end < mw->base + mw->window_len ? mw->dirty_end : mw->base + mw->window_len;
+    mw->dirty_start = mw->dirty_end = 0;
+    if (mw->window_len == 0 || start >= end) {
+        return 0;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    long aligned = (start - mw->base) / page * page;
+    return msync(mw->window + aligned, end - mw->base - aligned, MS_ASYNC);
+}
+
+// Ramène le fichier à sa longueur logique ; l'écriture suivante le réagrandit
+static int mapw_trim(MYFILE* file) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    if (mw->extent != mw->length) {
+        if (ftruncate(file->fd, mw->length) == -1) {
+            return -1;
+        }
+        mw->extent = mw->length;
+    }
+    mark_clean(file);
+    return 0;
+}
+
+static int mapw_close(MYFILE* file) {
+    MapWriter* mw = (MapWriter*)file->mapw;
+    int result = mapw_trim(file);
+    if (mw->window_len > 0) {
+        munmap(mw->window, mw->window_len);
+    }
+    mini_free(mw);
+    file->mapw = NULL;
+    return result;
+}
+
+// Flux en mémoire (mini_fmemopen) : map désigne les données, map_len leur
+// longueur et map_pos la position, si bien que les lectures passent par le
+// code du mode 'm'. Sans tampon fourni, les données sont dans une
+// projection anonyme que mremap agrandit sans copie.
+typedef struct {
+    long capacity;  // octets utilisables à partir de map
+    int owned;      // 1 : projection allouée ici, agrandie à la demande
+} MemStream;
+
+MYFILE* mini_fmemopen(void* buf, long len, char mode) {
+    if ((mode != 'r' && mode != 'w' && mode != 'b') || len < 0 || (buf == NULL && mode == 'r')) {
+        errno = EINVAL;
+        return NULL;
+    }
+    MYFILE* File = new_stream(mode);
+    if (File == NULL) {
+        return NULL;
+    }
+    MemStream* mem = (MemStream*)mini_calloc(sizeof(MemStream), 1);
+    if (!mem) {
+        mini_free(File);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (buf) {
+        File->map = (char*)buf;
+        File->map_len = mode == 'w' ? 0 : len; // 'w' : contenu ignoré
+        mem->capacity = len;
+    } else {
+        long page = sysconf(_SC_PAGESIZE);
+        long capacity = len > 0 ? (len + page - 1) / page * page : MEM_INITIAL;
+        void* data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            mini_free(mem);
+            mini_free(File);
+            errno = ENOMEM;
+            return NULL;
+        }
+        File->map = (char*)data;
+        mem->capacity = capacity;
+        mem->owned = 1;
+    }
+    File->fd = -1; // Aucun appel système
+    File->buffer_size = IOBUFFER_SIZE;
+    File->offset = 0;
+    File->read_base = 0;
+    File->mem = mem;
+    // Pas de descripteur ni de tampon à vider : hors de la table des flux ouverts
+    return File;
+}
+
+// Écrit len octets à offset sans déplacer la position ; un trou entre la fin
+// des données et offset est rempli de zéros
+static int mem_write_at(MYFILE* file, const char* data, int len, long offset) {
+    MemStream* mem = (MemStream*)file->mem;
+    if (file->mode == 'r') {
+        errno = EBADF;
+        return -1;
+    }
+    long end = offset + len;
+    if (end > mem->capacity) {
+        if (!mem->owned) {
+            errno = ENOSPC; // Tampon de l'appelant plein
+            return -1;
+        }
+        long capacity = mem->capacity;
+        while (capacity < end) {
+            capacity *= 2;
+        }
+        void* moved = mremap(file->map, mem->capacity, capacity, MREMAP_MAYMOVE);
+        if (moved == MAP_FAILED) {
+            errno = ENOMEM;
+            return -1;
+        }
+        file->map = (char*)moved;
+        mem->capacity = capacity;
+    }
+    if (offset > file->map_len) {
+        mini_memset(file->map + file->map_len, 0, (int)(offset - file->map_len));
+    }
+    mini_memcpy(file->map + offset, data, len);
+    if (end > file->map_len) {
+        file->map_len = end;
+    }
+    return len;
+}
+
+static void mem_close(MYFILE* file) {
+    MemStream* mem = (MemStream*)file->mem;
+    if (mem->owned) {
+        munmap(file->map, mem->capacity);
+    }
+    mini_free(mem);
+    file->mem = NULL;
+    file->map = NULL;
+}
+
+// Mode 'b', passage de la lecture à l'écriture : le descripteur est après
+// le tampon de lecture, il est ramené à la position logique et le tampon
+// abandonné pour ne pas relire des octets que l'écriture va remplacer
+static int drop_read_buffer(MYFILE* file) {
+    if (!file->buffer_read || file->end_read <= 0) {
+        return 0;
+    }
+    long position = file->read_base + file->ind_read;
+    if (position != file->offset) {
+        if (lseek(file->fd, position, SEEK_SET) == -1) {
+            return -1;
+        }
+        file->offset = position;
+    }
+    file->ind_read = 0;
+    file->end_read = 0;
+    return 0;
+}
+
+// Écrit un tampon plein ou partiel : tel quel, ou en bloc compressé
+static int write_buffer(MYFILE* file, const char* data, int len) {
+    if (file->lz) {
+        return lz_write_block(file, data, len);
+    }
+    return write_all(file, data, len);
+}
+
+// Recharge le tampon de lecture (alloué au besoin), retourne le nombre
+// d'octets lus, 0 en fin de fichier et -1 en cas d'erreur
+static int fill_read_buffer(MYFILE* file) {
+    if (!file->buffer_read) {
+        file->buffer_read = alloc_buffer(file);
+        if (!file->buffer_read) {
+            errno = ENOMEM;
+            return -1;
+        }
+        file->ind_read = 0; // Tampon vide : curseurs de début et de fin confondus
+        file->end_read = 0;
+    }
+    int result;
+    if (file->readahead) {
+        result = readahead_fill(file);
+    } else if (file->lz) {
+        file->read_base = file->offset;
+        result = lz_read_block(file, file->buffer_read);
+    } else {
+        file->read_base = file->offset; // Position du premier octet du tampon
+        // O_DIRECT exige une position alignée : après une fin de fichier non
+        // alignée, la lecture suivante passe par le cache
+        int restore = file->offset % DIRECT_ALIGN != 0 ? suspend_direct(file) : 0;
+        result = read_fd(file, file->buffer_read, file->buffer_size);
+        if (restore) {
+            set_direct(file, 1);
+        }
+    }
+    if (result > 0) {
+        file->ind_read = 0;
+        file->end_read = result; // Fin des données valides dans le tampon
+    }
+    return result;
+}
+
+// Repositionne un flux 'z' sur le bloc qui contient target
+static int lz_seek(MYFILE* file, long target) {
+    LzStream* lz = (LzStream*)file->lz;
+    int low = 0, high = lz->blocks - 1, block = -1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (lz->index[2 * middle + 1] <= target) {
+            block = middle;
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    if (block < 0 && target != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    lz->file_pos = block < 0 ? LZ_HEADER : lz->index[2 * block]; // Fichier vide : début
+    file->offset = block < 0 ? 0 : lz->index[2 * block + 1];
+    if (file->buffer_read) {
+        file->ind_read = 0;
+        file->end_read = 0;
+    }
+    int result = fill_read_buffer(file);
+    if (result < 0) {
+        return -1;
+    }
+    if (result > 0) {
+        file->ind_read = target - file->read_base < result ? (int)(target - file->read_base) : result;
+    }
+    return 0;
+}
+
+char* mini_fmap_view(MYFILE* file, long* len) {
+    if (!file || !file->map) {
+        if (len) {
+            *len = 0;
+        }
+        return NULL;
+    }
+    if (len) {
+        *len = file->map_len;
+    }
+    return file->map;
+}
+
+int mini_fread_unlocked(void* buffer, int size_element, int number_element, MYFILE* file) {
+    if (!buffer || !file || size_element <= 0 || number_element <= 0) {
+        errno = EINVAL; // Paramètres invalides
+        mini_perror("Invalid parameters");
+        return -1;
+    }
+
+    int total_size = size_element * number_element; // Taille totale à lire
+    int bytes_read = 0;                             // Nombre total de caractères lus
+    char* user_buffer = (char*)buffer;
+    long read_calls = file->stats.read_calls;      // Inchangé : servi par le tampon
+    file->stats.read_requests++;
+    if (file->mapw || (file->mem && file->mode == 'w')) {
+        errno = EBADF; // Mode 'M' ou flux mémoire 'w' : écriture seule
+        mini_perror("Error reading file");
+        return -1;
+    }
+
+    // Fichier projeté ou flux en mémoire : copie directe depuis les données
+    if (file->map) {
+        long available = file->map_pos < file->map_len ? file->map_len - file->map_pos : 0;
+        bytes_read = total_size < available ? total_size : (int)available;
+        mini_memcpy(user_buffer, file->map + file->map_pos, bytes_read);
+        file->map_pos += bytes_read;
+        file->stats.read_hits++;
+        return bytes_read;
+    }
+    // Mode 'b' : les écritures en attente précèdent la position de lecture
+    if (file->ind_write > 0 && flush_buffer(file) == -1) {
+        return -1;
+    }
+
+    while (bytes_read < total_size) {
+        // Tampon vide et au moins un tampon entier demandé (ou flux non
+        // tamponné) : lecture directe dans le buffer utilisateur
+        if (file->ind_read == file->end_read && !buffered_only(file)
+            && (total_size - bytes_read >= file->buffer_size || file->buffer_mode == MINI_IONBF)) {
+            int result = read_fd(file, user_buffer + bytes_read, total_size - bytes_read);
+            if (result == 0) {
+                break;
+            } else if (result < 0) {
+                mini_perror("Error reading file");
+                return -1;
+            }
+            bytes_read += result; // Lecture partielle : on boucle sur le reste
+            continue;
+        }
+
+        // Tampon vide (curseurs confondus) : lire un nouveau bloc depuis le fichier
+        if (file->ind_read == file->end_read || !file->buffer_read) {
+            int result = fill_read_buffer(file);
+            if (result == 0) {
+                // Fin de fichier atteinte
+                break;
+            } else if (result < 0) {
+                // Gestion des erreurs de lecture
+                mini_perror("Error reading file");
+                return -1;
+            }
+        }
+
+        // Calculer combien de données copier du tampon
+        int bytes_to_copy = total_size - bytes_read;
+        if (bytes_to_copy > file->end_read - file->ind_read) {
+            bytes_to_copy = file->end_read - file->ind_read;
+        }
+
+        // Copier les données du tampon vers le buffer utilisateur
+        mini_memcpy(user_buffer + bytes_read, (char*)file->buffer_read + file->ind_read, bytes_to_copy);
+
+        // Consommer les données : simple avancement du curseur, sans décalage
+        bytes_read += bytes_to_copy;
+        file->ind_read += bytes_to_copy;
+    }
+
+    if (file->stats.read_calls == read_calls) {
+        file->stats.read_hits++;
+    }
+    return bytes_read; // Retourne le nombre de caractères lus
+}
+
+int mini_fread(void* buffer, int size_element, int number_element, MYFILE* file) {
+    mini_flockfile(file);
+    int result = mini_fread_unlocked(buffer, size_element, number_element, file);
+    mini_funlockfile(file);
+    return result;
+}
+
+
+
+char* mini_fgetline_unlocked(MYFILE* file, int* len) {
+    if (!file || !len) {
+        errno = EINVAL;
+        return NULL;
+    }
+    *len = 0;
+    long read_calls = file->stats.read_calls;
+    file->stats.read_requests++;
+    if (file->mapw || (file->mem && file->mode == 'w')) {
+        errno = EBADF;
+        return NULL;
+    }
+
+    // Fichier projeté ou flux en mémoire : la ligne est directement dans les données
+    if (file->map) {
+        file->stats.read_hits++;
+        if (file->map_pos >= file->map_len) {
+            return NULL;
+        }
+        char* start = file->map + file->map_pos;
+        long remaining = file->map_len - file->map_pos;
+        int span = remaining < INT_MAX ? (int)remaining : INT_MAX;
+        char* newline = (char*)mini_memchr(start, '\n', span);
+        *len = newline ? (int)(newline - start) + 1 : span;
+        file->map_pos += *len;
+        return start;
+    }
+    if (file->ind_write > 0 && flush_buffer(file) == -1) {
+        return NULL;
+    }
+
+    if (file->ind_read >= file->end_read || !file->buffer_read) {
+        int result = fill_read_buffer(file);
+        if (result <= 0) {
+            if (result < 0) {
+                mini_perror("Error reading file");
+            }
+            return NULL;
+        }
+    }
+
+    // Cas courant : la ligne entière est dans le tampon, on pointe dessus
+    char* start = (char*)file->buffer_read + file->ind_read;
+    int available = file->end_read - file->ind_read;
+    char* newline = (char*)mini_memchr(start, '\n', available);
+    if (newline) {
+        *len = (int)(newline - start) + 1;
+        file->ind_read += *len;
+        if (file->stats.read_calls == read_calls) {
+            file->stats.read_hits++;
+        }
+        return start;
+    }
+
+    // Ligne à cheval sur plusieurs tampons : assemblée dans file->line,
+    // seul cas où les octets sont copiés
+    mini_strbuf_clear(&file->line);
+    while (1) {
+        if (mini_strbuf_append(&file->line, start, available) == -1) {
+            errno = ENOMEM;
+            mini_perror("Failed to grow line buffer");
+            return NULL;
+        }
+        file->ind_read = file->end_read;
+        int result = fill_read_buffer(file);
+        if (result < 0) {
+            mini_perror("Error reading file");
+            return NULL;
+        }
+        if (result == 0) {
+            break; // Dernière ligne sans '\n'
+        }
+        start = (char*)file->buffer_read;
+        available = result;
+        newline = (char*)mini_memchr(start, '\n', available);
+        if (newline) {
+            int head = (int)(newline - start) + 1;
+            if (mini_strbuf_append(&file->line, start, head) == -1) {
+                errno = ENOMEM;
+                mini_perror("Failed to grow line buffer");
+                return NULL;
+            }
+            file->ind_read = head;
+            break;
+        }
+    }
+    *len = file->line.len;
+    return file->line.data;
+}
+
+char* mini_fgetline(MYFILE* file, int* len) {
+    mini_flockfile(file);
+    char* line = mini_fgetline_unlocked(file, len);
+    mini_funlockfile(file);
+    return line;
+}
+
+int mini_fwrite_unlocked(void* buffer, int size_element, int number_element, MYFILE* file) {
+    if (!buffer || !file || size_element <= 0 || number_element <= 0) {
+        errno = EINVAL; // Paramètres invalides
+        return -1;
+    }
+
+    int total_size = size_element * number_element; // Taille totale à écrire
+    int bytes_written = 0; // Nombre total d'octets effectivement écrits
+    char* user_buffer = (char*)buffer;
+    long write_calls = file->stats.write_calls; // Inchangé : absorbé par le tampon
+    file->stats.write_requests++;
+
+    // Mode 'M' : copie directe dans la projection, sans tampon ni write()
+    if (file->mapw) {
+        if (mapw_write(file, user_buffer, total_size) == -1) {
+            mini_perror("Error writing to file");
+            return -1;
+        }
+        file->stats.write_hits++;
+        return total_size;
+    }
+
+    // Flux en mémoire : copie à la position courante
+    if (file->mem) {
+        if (mem_write_at(file, user_buffer, total_size, file->map_pos) == -1) {
+            mini_perror("Error writing to file");
+            return -1;
+        }
+        file->map_pos += total_size;
+        file->stats.write_hits++;
+        return total_size;
+    }
+
+    if (drop_read_buffer(file) == -1) {
+        mini_perror("Error writing to file");
+        return -1;
+    }
+
+    // Gros transfert ou flux non tamponné : vider le tampon puis écrire
+    // directement depuis le buffer utilisateur
+    if ((total_size >= file->buffer_size || file->buffer_mode == MINI_IONBF) && !buffered_only(file)) {
+        if (file->ind_write > 0 && flush_buffer(file) == -1) {
+            return -1;
+        }
+        if (write_all(file, user_buffer, total_size) == -1) {
+            mini_perror("Error writing to file");
+            return -1;
+        }
+        return total_size;
+    }
+
+    // Allocation du tampon d'écriture si nécessaire
+    if (!file->buffer_write) {
+        file->buffer_write = alloc_buffer(file);
+        if (!file->buffer_write) {
+            errno = ENOMEM; // Échec d'allocation mémoire
+            return -1;
+        }
+        file->ind_write = 0; // Initialisation de l'indice d'écriture
+    }
+
+    while (bytes_written < total_size) {
+        // Calcul de l'espace disponible dans le tampon
+        int available_space = file->buffer_size - file->ind_write;
+
+        // Calculer combien d'octets on peut écrire dans le tampon
+        int bytes_to_copy = total_size - bytes_written;
+        if (bytes_to_copy > available_space) {
+            bytes_to_copy = available_space;
+        }
+
+        // Copier les données dans le tampon d'écriture
+        mini_memcpy((char*)file->buffer_write + file->ind_write, 
+                    user_buffer + bytes_written, 
+                    bytes_to_copy);
+
+        file->ind_write += bytes_to_copy;
+        bytes_written += bytes_to_copy;
+
+        // Si le tampon est plein, déclencher une écriture
+        if (file->ind_write == file->buffer_size) {
+            int result = write_buffer(file, file->buffer_write, file->buffer_size);
+            if (result == -1) {
+                mini_perror("Error writing to file");
+                return -1; // Échec d'écriture
+            }
+            file->ind_write = 0; // Réinitialiser l'indicateur d'écriture
+        }
+    }
+
+    // Un tampon vidé par la dernière copie n'a plus rien à écrire à la sortie
+    if (file->ind_write > 0) {
+        mark_dirty(file);
+    } else {
+        mark_clean(file);
+    }
+
+    // Tampon par ligne : vider dès qu'une fin de ligne a été écrite
+    if (file->buffer_mode == MINI_IOLBF && mini_memchr(user_buffer, '\n', total_size)) {
+        if (flush_buffer(file) == -1) {
+            return -1;
+        }
+    }
+
+    if (file->stats.write_calls == write_calls) {
+        file->stats.write_hits++;
+    }
+    return bytes_written; // Retourne le nombre d'octets écrits
+}
+
+int mini_fwrite(void* buffer, int size_element, int number_element, MYFILE* file) {
+    mini_flockfile(file);
+    int result = mini_fwrite_unlocked(buffer, size_element, number_element, file);
+    mini_funlockfile(file);
+    return result;
+}
+
+
+#define IOV_STACK 64 // Au-delà, la copie du tableau d'iovec est allouée
+#ifndef IOV_MAX
+#define IOV_MAX 1024    // Nombre maximal d'iovec par appel système sous Linux
+#endif
+
+// Copie un tableau d'iovec (writev/readv le consomment au fil des transferts partiels)
+static struct iovec* copy_iov(const struct iovec* iov, int iovcnt, int extra,
+                              struct iovec* stack_iov) {
+    struct iovec* copy = stack_iov;
+    if (iovcnt + extra > IOV_STACK) {
+        copy = (struct iovec*)mini_calloc(sizeof(struct iovec), iovcnt + extra);
+        if (!copy) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    mini_memcpy(copy + extra, iov, iovcnt * (int)sizeof(struct iovec));
+    return copy;
+}
+
+// Avance dans le tableau d'iovec de done octets, retourne le nouveau début
+static struct iovec* skip_iov(struct iovec* iov, int* iovcnt, long done) {
+    while (*iovcnt > 0 && done >= (long)iov->iov_len) {
+        done -= iov->iov_len;
+        iov++;
+        (*iovcnt)--;
+    }
+    if (*iovcnt > 0) {
+        iov->iov_base = (char*)iov->iov_base + done;
+        iov->iov_len -= done;
+    }
+    return iov;
+}
+
+static int fwritev_unlocked(MYFILE* file, const struct iovec* iov, int iovcnt) {
+    if (!file || !iov || iovcnt <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    long total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    // Petit enregistrement (ou flux sans accès direct) : les morceaux sont regroupés dans le tampon du flux
+    if ((total < file->buffer_size && file->buffer_mode != MINI_IONBF) || buffered_only(file)) {
+        for (int i = 0; i < iovcnt; i++) {
+            if (iov[i].iov_len > 0 && mini_fwrite_unlocked(iov[i].iov_base, 1, iov[i].iov_len, file) == -1) {
+                return -1;
+            }
+        }
+        return (int)total;
+    }
+    if (drop_read_buffer(file) == -1) {
+        mini_perror("Error writing to file");
+        return -1;
+    }
+
+    // Gros enregistrement : tampon en attente + morceaux en un seul writev
+    struct iovec stack_iov[IOV_STACK];
+    struct iovec* all = copy_iov(iov, iovcnt, 1, stack_iov);
+    if (!all) {
+        return -1;
+    }
+    int pending = file->ind_write > 0 ? file->ind_write : 0;
+    all[0].iov_base = file->buffer_write;
+    all[0].iov_len = pending;
+    struct iovec* current = all;
+    int count = iovcnt + 1;
+    long remaining = total + pending;
+    while (remaining > 0) {
+        long start = stats_clock();
+        int result = writev(file->fd, current, count < IOV_MAX ? count : IOV_MAX);
+        note_write(file, start, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            mini_perror("Error writing to file");
+            if (all != stack_iov) {
+                mini_free(all);
+            }
+            return -1;
+        }
+        file->offset += result;
+        remaining -= result;
+        current = skip_iov(current, &count, result);
+    }
+    if (pending > 0) {
+        file->ind_write = 0;
+        mark_clean(file);
+    }
+    if (all != stack_iov) {
+        mini_free(all);
+    }
+    return (int)total;
+}
+
+int mini_fwritev(MYFILE* file, const struct iovec* iov, int iovcnt) {
+    mini_flockfile(file);
+    int result = fwritev_unlocked(file, iov, iovcnt);
+    mini_funlockfile(file);
+    return result;
+}
+
+static int freadv_unlocked(MYFILE* file, const struct iovec* iov, int iovcnt) {
+    if (!file || !iov || iovcnt <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    long total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    // Petite lecture (ou fichier projeté, flux sans accès direct) : servie par le tampon du flux
+    if ((total < file->buffer_size && file->buffer_mode != MINI_IONBF) || file->map || buffered_only(file)) {
+        int bytes_read = 0;
+        for (int i = 0; i < iovcnt; i++) {
+            if (iov[i].iov_len == 0) {
+                continue;
+            }
+            int result = mini_fread_unlocked(iov[i].iov_base, 1, iov[i].iov_len, file);
+            if (result == -1) {
+                return -1;
+            }
+            bytes_read += result;
+            if (result < (int)iov[i].iov_len) {
+                break; // Fin de fichier
+            }
+        }
+        return bytes_read;
+    }
+    if (file->ind_write > 0 && flush_buffer(file) == -1) {
+        return -1;
+    }
+
+    struct iovec stack_iov[IOV_STACK];
+    struct iovec* all = copy_iov(iov, iovcnt, 0, stack_iov);
+    if (!all) {
+        return -1;
+    }
+    struct iovec* current = all;
+    int count = iovcnt;
+    long bytes_read = 0;
+
+    // D'abord les octets déjà dans le tampon
+    int buffered = file->end_read - file->ind_read;
+    while (buffered > 0 && count > 0) {
+        int n = buffered < (int)current->iov_len ? buffered : (int)current->iov_len;
+        mini_memcpy(current->iov_base, (char*)file->buffer_read + file->ind_read, n);
+        file->ind_read += n;
+        buffered -= n;
+        bytes_read += n;
+        current = skip_iov(current, &count, n);
+    }
+
+    // Puis le reste directement depuis le fichier, en un readv par transfert
+    while (count > 0) {
+        long start = stats_clock();
+        int result = readv(file->fd, current, count < IOV_MAX ? count : IOV_MAX);
+        stats_read(&file->stats, start, total - bytes_read, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            mini_perror("Error reading file");
+            if (all != stack_iov) {
+                mini_free(all);
+            }
+            return -1;
+        }
+        if (result == 0) {
+            break;
+        }
+        file->offset += result;
+        bytes_read += result;
+        current = skip_iov(current, &count, result);
+    }
+    if (all != stack_iov) {
+        mini_free(all);
+    }
+    return (int)bytes_read;
+}
+
+int mini_freadv(MYFILE* file, const struct iovec* iov, int iovcnt) {
+    mini_flockfile(file);
+    int result = freadv_unlocked(file, iov, iovcnt);
+    mini_funlockfile(file);
+    return result;
+}
+
+static long ftell_unlocked(MYFILE* file) {
+    if (!file) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (file->map) {
+        return file->map_pos;
+    }
+    if (file->mapw) {
+        return ((MapWriter*)file->mapw)->pos;
+    }
+    // Position du descripteur, plus ce qui attend dans le tampon d'écriture,
+    // ou moins ce qui a été lu d'avance : les deux tampons ne sont jamais
+    // remplis en même temps (drop_read_buffer, flush avant lecture)
+    long position = file->offset;
+    if (file->ind_write > 0) {
+        position += file->ind_write;
+    } else if (file->end_read > file->ind_read) {
+        position -= file->end_read - file->ind_read;
+    }
+    return position;
+}
+
+long mini_ftell(MYFILE* file) {
+    mini_flockfile(file);
+    long result = ftell_unlocked(file);
+    mini_funlockfile(file);
+    return result;
+}
+
+// 1 si le tampon de lecture reflète encore le fichier juste avant file->offset
+static int read_buffer_valid(MYFILE* file) {
+    return file->buffer_read && file->end_read > 0 && file->read_base + file->end_read == file->offset;
+}
+
+static int fseek_unlocked(MYFILE* file, long offset, int whence) {
+    if (!file) {
+        errno = EINVAL;
+        return -1;
+    }
+    long current = ftell_unlocked(file);
+    long target;
+    if (whence == SEEK_SET) {
+        target = offset;
+    } else if (whence == SEEK_CUR) {
+        target = current + offset;
+    } else if (whence == SEEK_END && file->mem) {
+        target = file->map_len + offset;
+    } else if (whence == SEEK_END && file->lz) {
+        // La taille du fichier est celle des données compressées ; un flux
+        // 'Z' s'écrit d'un seul tenant, sa fin est la position courante
+        long end = file->mode == 'Z' ? current : lz_length(file);
+        if (end < 0) {
+            return -1;
+        }
+        target = end + offset;
+    } else if (whence == SEEK_END) {
+        struct stat info;
+        if (fstat(file->fd, &info) == -1) {
+            return -1;
+        }
+        // Les écritures en attente peuvent prolonger le fichier ; en mode 'M'
+        // le fichier est plus long que ce qui a été écrit
+        long end = file->mapw ? ((MapWriter*)file->mapw)->length : info.st_size;
+        if (file->ind_write > 0 && file->offset + file->ind_write > end) {
+            end = file->offset + file->ind_write;
+        }
+        target = end + offset;
+    } else {
+        errno = EINVAL;
+        return -1;
+    }
+    if (target < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (file->map) {
+        file->map_pos = target;
+        return 0;
+    }
+    if (file->mapw) {
+        ((MapWriter*)file->mapw)->pos = target; // Un trou se lit comme des zéros
+        return 0;
+    }
+    if (target == current) {
+        return 0; // Rien à vider ni à relire
+    }
+    if (file->lz && file->mode == 'Z') {
+        errno = ESPIPE; // Un flux compressé s'écrit d'un seul tenant
+        return -1;
+    }
+
+    if (file->ind_write > 0 && (flush_buffer(file) == -1 || direct_settle(file) == -1)) {
+        return -1;
+    }
+    // Cible dans le tampon de lecture : simple déplacement du curseur
+    if (read_buffer_valid(file) && target >= file->read_base && target <= file->offset) {
+        file->ind_read = (int)(target - file->read_base);
+        return 0;
+    }
+    if (file->lz) {
+        return lz_seek(file, target);
+    }
+    if (file->readahead) {
+        if (readahead_seek(file, target) == -1) {
+            return -1;
+        }
+    } else if (file->direct && file->mode == 'd') {
+        // Lecture directe : relire le bloc aligné qui contient la cible
+        long base = target / DIRECT_ALIGN * DIRECT_ALIGN;
+        if (lseek(file->fd, base, SEEK_SET) == -1) {
+            return -1;
+        }
+        file->offset = base;
+        if (file->buffer_read) {
+            file->ind_read = 0;
+            file->end_read = 0;
+        }
+        int result = fill_read_buffer(file);
+        if (result < 0) {
+            return -1;
+        }
+        if (result > 0) {
+            file->ind_read = target - base < result ? (int)(target - base) : result;
+        }
+        return 0;
+    } else if (file->direct && target % DIRECT_ALIGN != 0) {
+        // Écriture directe à une position non alignée : le flux repasse par le cache
+        if (lseek(file->fd, target, SEEK_SET) == -1) {
+            return -1;
+        }
+        set_direct(file, 0);
+    } else if (lseek(file->fd, target, SEEK_SET) == -1) {
+        return -1;
+    }
+    file->offset = target;
+    if (file->buffer_read) {
+        file->ind_read = 0;
+        file->end_read = 0;
+    }
+    return 0;
+}
+
+int mini_fseek(MYFILE* file, long offset, int whence) {
+    mini_flockfile(file);
+    int result = fseek_unlocked(file, offset, whence);
+    mini_funlockfile(file);
+    return result;
+}
+
+static int fpread_unlocked(MYFILE* file, void* buffer, int size, long offset) {
+    if (!file || !buffer || size < 0 || offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (file->lz) {
+        errno = ESPIPE; // Positions compressées et décompressées diffèrent
+        return -1;
+    }
+    if (file->mapw || (file->mem && file->mode == 'w')) {
+        errno = EBADF;
+        return -1;
+    }
+    if (file->map) {
+        long available = offset < file->map_len ? file->map_len - offset : 0;
+        int n = size < available ? size : (int)available;
+        mini_memcpy(buffer, file->map + offset, n);
+        return n;
+    }
+    // Plage entièrement dans le tampon de lecture : aucun appel système
+    if (read_buffer_valid(file) && offset >= file->read_base
+        && offset + size <= file->read_base + file->end_read) {
+        mini_memcpy(buffer, (char*)file->buffer_read + (offset - file->read_base), size);
+        return size;
+    }
+    // Les écritures en attente doivent être visibles par la lecture
+    if (file->ind_write > 0 && flush_buffer(file) == -1) {
+        return -1;
+    }
+    int restore = suspend_direct(file); // Buffer de l'appelant non aligné
+    int done = 0;
+    while (done < size) {
+        long start = stats_clock();
+        int result = pread(file->fd, (char*)buffer + done, size - done, offset + done);
+        stats_read(&file->stats, start, size - done, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            mini_perror("Error reading file");
+            done = -1;
+            break;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += result;
+    }
+    if (restore) {
+        set_direct(file, 1);
+    }
+    return done;
+}
+
+int mini_fpread(MYFILE* file, void* buffer, int size, long offset) {
+    mini_flockfile(file);
+    int result = fpread_unlocked(file, buffer, size, offset);
+    mini_funlockfile(file);
+    return result;
+}
+
+static int fpwrite_unlocked(MYFILE* file, void* buffer, int size, long offset) {
+    if (!file || !buffer || size < 0 || offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (file->lz) {
+        errno = ESPIPE;
+        return -1;
+    }
+    if (file->mapw) {
+        errno = EINVAL; // La longueur logique n'est tenue que par mini_fwrite
+        return -1;
+    }
+    if (file->mem) {
+        return mem_write_at(file, (char*)buffer, size, offset);
+    }
+    // Vider le tampon d'écriture seulement s'il recouvre la plage visée,
+    // sinon il écraserait plus tard les nouvelles données
+    if (file->ind_write > 0 && offset < file->offset + file->ind_write && offset + size > file->offset) {
+        if (flush_buffer(file) == -1) {
+            return -1;
+        }
+    }
+    int restore = suspend_direct(file);
+    int done = 0;
+    while (done < size) {
+        long start = stats_clock();
+        int result = pwrite(file->fd, (char*)buffer + done, size - done, offset + done);
+        note_write(file, start, result);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result == -1) {
+            break;
+        }
+        done += result;
+    }
+    if (restore) {
+        set_direct(file, 1);
+    }
+    if (done < size) {
+        mini_perror("Error writing to file");
+        return -1;
+    }
+    // Fin non alignée conservée par un flux O_DIRECT : elle sera réécrite,
+    // elle doit donc refléter les nouvelles données
+    if (file->ind_write > 0) {
+        long start = offset > file->offset ? offset : file->offset;
+        long end = offset + size < file->offset + file->ind_write ? offset + size : file->offset + file->ind_write;
+        if (start < end) {
+            mini_memcpy((char*)file->buffer_write + (start - file->offset),
+                        (char*)buffer + (start - offset), (int)(end - start));
+        }
+    }
+    // Garder le tampon de lecture cohérent en y recopiant la partie recouverte
+    if (read_buffer_valid(file)) {
+        long start = offset > file->read_base ? offset : file->read_base;
+        long end = offset + size < file->offset ? offset + size : file->offset;
+        if (start < end) {
+            mini_memcpy((char*)file->buffer_read + (start - file->read_base),
+                        (char*)buffer + (start - offset), (int)(end - start));
+        }
+    }
+    return done;
+}
+
+int mini_fpwrite(MYFILE* file, void* buffer, int size, long offset) {
+    mini_flockfile(file);
+    int result = fpwrite_unlocked(file, buffer, size, offset);
+    mini_funlockfile(file);
+    return result;
+}
+
+// Prépare le flux à une E/S faite hors de ses tampons (mini_async.c) :
+// écritures en attente envoyées, lecture d'avance abandonnée, puis la
+// position logique avance de advance octets ; retourne la position d'avant
+long mini_fhandoff(MYFILE* file, long advance) {
+    if (!file || advance < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (file->lz || file->mem) {
+        errno = EINVAL; // Pas de descripteur dont les octets sont ceux du flux
+        return -1;
+    }
+    mini_flockfile(file);
+    long position = ftell_unlocked(file);
+    int result = position < 0 ? -1 : 0;
+    if (result == 0 && file->ind_write > 0 && (flush_buffer(file) == -1 || direct_settle(file) == -1)) {
+        result = -1;
+    }
+    if (result == 0) {
+        // Le tampon vidé, le flux est à file->offset : fseek replace le
+        // descripteur (ou la lecture anticipée) à la position logique
+        if (file->buffer_read) {
+            file->ind_read = 0;
+            file->end_read = 0;
+        }
+        result = fseek_unlocked(file, position + advance, SEEK_SET);
+    }
+    mini_funlockfile(file);
+    return result == -1 ? -1 : position;
+}
+
+// Vide le tampon d'écriture vers le noyau
+static int flush_buffer(MYFILE* file) {
+    if (file && file->mapw) {
+        if (mapw_flush(file) == -1) {
+            mini_perror("Error flushing buffer");
+            return -1;
+        }
+        return 0;
+    }
+    if (!file) {
+        return 0;
+    }
+    if (!file->buffer_write || file->ind_write <= 0) {
+        mark_clean(file); // Rien à écrire : le flux ne doit plus être parcouru
+        return 0;
+    }
+    file->stats.flushes++;
+
+    // O_DIRECT et fin non alignée : la partie alignée est écrite en direct, la
+    // fin passe par le cache sans avancer la position, et reste dans le tampon
+    // pour être réécrite en entier par la prochaine écriture directe
+    if (file->direct && file->ind_write % DIRECT_ALIGN != 0) {
+        int aligned = file->ind_write / DIRECT_ALIGN * DIRECT_ALIGN;
+        int tail = file->ind_write - aligned;
+        if (aligned > 0 && write_all(file, file->buffer_write, aligned) == -1) {
+            mini_perror("Error flushing buffer");
+            return -1;
+        }
+        char* rest = (char*)file->buffer_write + aligned;
+        int restore = suspend_direct(file);
+        int done = 0;
+        while (done < tail) {
+            long start = stats_clock();
+            int result = pwrite(file->fd, rest + done, tail - done, file->offset + done);
+            note_write(file, start, result);
+            if (result == -1 && errno == EINTR) {
+                continue;
+            }
+            if (result == -1) {
+                break;
+            }
+            done += result;
+        }
+        if (restore) {
+            set_direct(file, 1);
+        }
+        if (done < tail) {
+            mini_perror("Error flushing buffer");
+            return -1;
+        }
+        mini_memmove(file->buffer_write, rest, tail);
+        file->ind_write = tail;
+        mark_clean(file); // Tout est dans le fichier
+        return aligned + tail;
     }
 
     // Écrire les données restantes du tampon dans le fichier
-    int result = write(file->fd, file->buffer_write, file->ind_write);
+    int result = write_buffer(file, file->buffer_write, file->ind_write);
     if (result == -1) {
         mini_perror("Error flushing buffer");
         return -1; // Erreur lors de l'écriture
@@ -271,54 +2514,665 @@ int mini_fflush(MYFILE* file) {
 
     // Réinitialiser l'indicateur d'écriture après une écriture réussie
     file->ind_write = 0;
+    mark_clean(file);
 
     return result; // Retourne le nombre d'octets écrits
 }
 
+// Politique de durabilité d'un flux (mini_fsetsync). Les positions comparées
+// sont des totaux d'octets confiés au noyau par le flux (handed) : un
+// fdatasync commencé après l'écriture de written octets les rend durables.
+typedef struct {
+    int mode;
+    long interval_ns;   // MINI_SYNC_PERIODIC : écart minimal entre deux fdatasync,
+                        // MINI_SYNC_GROUP : attente du meneur avant son fdatasync
+    long last_sync;     // date du dernier fdatasync (stats_clock)
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    long synced;        // octets rendus durables
+    long requested;     // plus grande position attendue par un appelant
+    int syncing;        // un meneur de groupe est en cours de fdatasync
+    int result;         // résultat de son dernier fdatasync
+    int error;
+    long syncs;         // recopié dans stats.syncs par mini_fstats et mini_fclose
+} SyncState;
+
+static int sync_data(int fd, SyncState* sync, long target) {
+    int result = fdatasync(fd);
+    int error = errno;
+    pthread_mutex_lock(&sync->lock);
+    if (result == 0 && target > sync->synced) {
+        sync->synced = target;
+    }
+    sync->syncs++;
+    sync->last_sync = stats_clock();
+    pthread_mutex_unlock(&sync->lock);
+    errno = error;
+    return result;
+}
+
+// Rend durables les written premiers octets écrits selon la politique du
+// flux. Appelée sans le verrou du flux en mode groupe, pour que d'autres
+// threads puissent écrire et rejoindre le prochain fdatasync.
+static int file_sync(MYFILE* file, long written) {
+    SyncState* sync = (SyncState*)file->sync;
+    if (!sync || sync->mode == MINI_SYNC_NONE) {
+        return 0;
+    }
+    pthread_mutex_lock(&sync->lock);
+    if (sync->synced >= written) {
+        pthread_mutex_unlock(&sync->lock); // Déjà couvert par un fdatasync
+        return 0;
+    }
+    if (sync->mode == MINI_SYNC_PERIODIC && stats_clock() - sync->last_sync < sync->interval_ns) {
+        pthread_mutex_unlock(&sync->lock);
+        return 0;
+    }
+    if (sync->mode != MINI_SYNC_GROUP) {
+        pthread_mutex_unlock(&sync->lock);
+        return sync_data(file->fd, sync, written);
+    }
+
+    // Groupe : le premier arrivé mène, les suivants attendent son fdatasync
+    // ou le prochain si leurs octets sont arrivés après son début
+    if (written > sync->requested) {
+        sync->requested = written;
+    }
+    while (sync->synced < written) {
+        if (!sync->syncing) {
+            sync->syncing = 1;
+            if (sync->interval_ns > 0) {
+                pthread_mutex_unlock(&sync->lock);
+                struct timespec window = {sync->interval_ns / 1000000000L, sync->interval_ns % 1000000000L};
+                nanosleep(&window, NULL);
+                pthread_mutex_lock(&sync->lock);
+            }
+            long target = sync->requested;
+            pthread_mutex_unlock(&sync->lock);
+            int result = fdatasync(file->fd);
+            int error = errno;
+            pthread_mutex_lock(&sync->lock);
+            if (result == 0) {
+                sync->synced = target;
+            }
+            sync->syncs++;
+            sync->last_sync = stats_clock();
+            sync->result = result;
+            sync->error = error;
+            sync->syncing = 0;
+            pthread_cond_broadcast(&sync->cond);
+            if (result == -1) {
+                break;
+            }
+        } else {
+            pthread_cond_wait(&sync->cond, &sync->lock);
+            if (sync->result == -1 && sync->synced < written) {
+                break; // Le fdatasync du groupe a échoué
+            }
+        }
+    }
+    int result = sync->synced >= written ? 0 : -1;
+    int error = sync->error;
+    pthread_mutex_unlock(&sync->lock);
+    if (result == -1) {
+        errno = error;
+        mini_perror("Error syncing file");
+    }
+    return result;
+}
+
+// fdatasync faits pour un flux ouvert (compteur tenu hors du verrou du flux)
+static long sync_count(MYFILE* file) {
+    SyncState* sync = (SyncState*)file->sync;
+    if (!sync) {
+        return 0;
+    }
+    pthread_mutex_lock(&sync->lock);
+    long syncs = sync->syncs;
+    pthread_mutex_unlock(&sync->lock);
+    return syncs;
+}
+
+int mini_fsetsync(MYFILE* file, int mode, int interval_us) {
+    if (!file || file->mem || mode < MINI_SYNC_NONE || mode > MINI_SYNC_GROUP || interval_us < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    mini_flockfile(file);
+    SyncState* sync = (SyncState*)file->sync;
+    if (!sync) {
+        sync = (SyncState*)mini_calloc(sizeof(SyncState), 1);
+        if (!sync) {
+            mini_funlockfile(file);
+            errno = ENOMEM;
+            return -1;
+        }
+        pthread_mutex_init(&sync->lock, NULL);
+        pthread_cond_init(&sync->cond, NULL);
+        sync->synced = file->handed; // Écrit avant : pas concerné
+        sync->last_sync = stats_clock();
+        file->sync = sync;
+    }
+    pthread_mutex_lock(&sync->lock);
+    sync->mode = mode;
+    sync->interval_ns = interval_us * 1000L;
+    pthread_mutex_unlock(&sync->lock);
+    mini_funlockfile(file);
+    return 0;
+}
+
+int mini_fflush_unlocked(MYFILE* file) {
+    int result = flush_buffer(file);
+    if (result == -1 || !file) {
+        return result;
+    }
+    return file_sync(file, file->handed) == -1 ? -1 : result;
+}
+
+int mini_fflush(MYFILE* file) {
+    mini_flockfile(file);
+    int result = flush_buffer(file);
+    long written = file ? file->handed : 0;
+    mini_funlockfile(file);
+    if (result == -1 || !file) {
+        return result;
+    }
+    return file_sync(file, written) == -1 ? -1 : result;
+}
+
+// Vide count octets du tube vers out ; si out refuse splice (O_APPEND par
+// exemple), le reste passe par read/write et *by_write est mis à 1.
+// Retourne les octets écrits, moins que count en cas d'erreur (errno)
+static long pipe_drain(int pipe_out, int out, long count, int* by_write) {
+    long moved = 0;
+    while (moved < count && !*by_write) {
+        ssize_t n = splice(pipe_out, NULL, out, NULL, count - moved, SPLICE_F_MOVE);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            *by_write = 1;
+            break;
+        }
+        moved += n;
+    }
+    char buffer[4096];
+    while (moved < count) {
+        int want = count - moved > (long)sizeof(buffer) ? (int)sizeof(buffer) : (int)(count - moved);
+        int n = read(pipe_out, buffer, want);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        int done = 0;
+        while (done < n) {
+            int w = write(out, buffer + done, n - done);
+            if (w == -1 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                return moved + done; // Le reste du tube est perdu
+            }
+            done += w;
+        }
+        moved += n;
+    }
+    return moved;
+}
+
+static long kernel_copy_with(int out, int in, loff_t* in_off, long len, int* pipe_fds) {
+    long total = 0;
+    int method = 0;
+    while (len < 0 || total < len) {
+        size_t chunk = len < 0 || len - total > COPY_CHUNK ? COPY_CHUNK : (size_t)(len - total);
+        ssize_t result = -1;
+        if (method == 0) {
+            result = copy_file_range(in, in_off, out, NULL, chunk, 0);
+        } else if (method == 1) {
+            result = sendfile(out, in, (off_t*)in_off, chunk);
+        } else if (method == 2) {
+            // Un seul tube pour toute la copie, agrandi si le noyau l'accepte
+            if (pipe_fds[0] == -1 && pipe(pipe_fds) == 0) {
+                fcntl(pipe_fds[1], F_SETPIPE_SZ, COPY_PIPE);
+            }
+            if (pipe_fds[0] != -1) {
+                result = splice(in, in_off, pipe_fds[1], NULL, chunk, SPLICE_F_MOVE);
+            }
+            if (result > 0) {
+                int by_write = 0;
+                long moved = pipe_drain(pipe_fds[0], out, result, &by_write);
+                if (by_write) {
+                    method = 3; // out refuse splice : la boucle read/write pour la suite
+                }
+                if (moved < result) {
+                    // Écriture en échec : les octets sortis de in restés dans le
+                    // tube sont rendus à in s'il se repositionne, et la copie
+                    // s'arrête sur le compte des octets écrits
+                    if (in_off) {
+                        *in_off -= result - moved;
+                    } else {
+                        int error = errno;
+                        lseek(in, moved - result, SEEK_CUR);
+                        errno = error;
+                    }
+                    total += moved;
+                    return total > 0 ? total : -1;
+                }
+            }
+        } else {
+            // Boucle de secours : la seule méthode qui passe par l'espace utilisateur
+            char* buffer = (char*)mini_calloc(COPY_BUFFER, 1);
+            if (!buffer) {
+                errno = ENOMEM;
+                return total > 0 ? total : -1;
+            }
+            while (len < 0 || total < len) {
+                int want = len < 0 || len - total > COPY_BUFFER ? COPY_BUFFER : (int)(len - total);
+                int n = in_off ? pread(in, buffer, want, *in_off) : read(in, buffer, want);
+                if (n == -1 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    result = n;
+                    break;
+                }
+                int done = 0;
+                while (done < n) {
+                    int w = write(out, buffer + done, n - done);
+                    if (w == -1 && errno == EINTR) {
+                        continue;
+                    }
+                    if (w == -1) {
+                        mini_free(buffer);
+                        return -1;
+                    }
+                    done += w;
+                }
+                if (in_off) {
+                    *in_off += n;
+                }
+                total += n;
+            }
+            mini_free(buffer);
+            return result < 0 && total == 0 ? -1 : total;
+        }
+
+        if (result == 0) {
+            break; // Fin de fichier
+        }
+        if (result < 0 && errno == EINTR) {
+            continue; // Interrompu avant tout transfert : on relance
+        }
+        if (result < 0) {
+            // Méthode non prise en charge pour ces descripteurs : la suivante.
+            // Une erreur en cours de copie est une vraie erreur.
+            if (total == 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP
+                               || errno == EBADF || errno == ESPIPE)) {
+                method++;
+                continue;
+            }
+            return total > 0 ? total : -1;
+        }
+        total += result;
+    }
+    return total;
+}
+
+// Copie noyau de in vers out, jusqu'à len octets (len < 0 : jusqu'à la fin).
+// in_off non NULL : position de lecture explicite, le descripteur ne bouge pas.
+// Essaie copy_file_range, puis sendfile, puis splice à travers un tube, et
+// en dernier recours une boucle read/write ; retourne les octets copiés.
+static long kernel_copy(int out, int in, loff_t* in_off, long len) {
+    int pipe_fds[2] = {-1, -1};
+    long result = kernel_copy_with(out, in, in_off, len, pipe_fds);
+    if (pipe_fds[0] != -1) {
+        int error = errno;
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        errno = error;
+    }
+    return result;
+}
+
+static long fcopy_unlocked(MYFILE* dst, MYFILE* src, long len) {
+    if (src->mem) {
+        // Source en mémoire : dst reçoit les octets directement depuis ses données
+        if (src->mode == 'w') {
+            errno = EBADF;
+            return -1;
+        }
+        long available = src->map_pos < src->map_len ? src->map_len - src->map_pos : 0;
+        long total = len < 0 || len > available ? available : len;
+        long copied = 0;
+        while (copied < total) {
+            int n = total - copied > COPY_BUFFER ? COPY_BUFFER : (int)(total - copied);
+            if (mini_fwrite_unlocked(src->map + src->map_pos, 1, n, dst) == -1) {
+                return -1;
+            }
+            src->map_pos += n;
+            copied += n;
+        }
+        return copied;
+    }
+    if (src->lz || dst->lz || src->mapw || dst->mapw || dst->mem) {
+        // Flux compressé, projeté ou en mémoire : les octets doivent passer
+        // par le (dé)compresseur, la projection ou mini_fwrite
+        char* buffer = (char*)mini_calloc(COPY_BUFFER, 1);
+        if (!buffer) {
+            errno = ENOMEM;
+            return -1;
+        }
+        long total = 0;
+        while (len < 0 || total < len) {
+            int want = len < 0 || len - total > COPY_BUFFER ? COPY_BUFFER : (int)(len - total);
+            int n = mini_fread_unlocked(buffer, 1, want, src);
+            if (n <= 0) {
+                if (n < 0) {
+                    total = -1;
+                }
+                break;
+            }
+            if (mini_fwrite_unlocked(buffer, 1, n, dst) == -1) {
+                total = -1;
+                break;
+            }
+            total += n;
+        }
+        mini_free(buffer);
+        return total;
+    }
+    // Écritures en attente de src (mode 'b') : elles font partie de la copie ;
+    // dst (mode 'b') doit écrire à sa position logique, pas après son tampon
+    // de lecture
+    if (src->ind_write > 0 && flush_buffer(src) == -1) {
+        return -1;
+    }
+    if (drop_read_buffer(dst) == -1) {
+        return -1;
+    }
+    // Les octets déjà dans le tampon de src sont en espace utilisateur : ils
+    // rejoignent le tampon de dst, qui est ensuite vidé
+    long copied = 0;
+    if (!src->map && src->buffer_read && src->end_read > src->ind_read) {
+        int pending = src->end_read - src->ind_read;
+        if (len >= 0 && pending > len) {
+            pending = (int)len;
+        }
+        if (mini_fwrite_unlocked((char*)src->buffer_read + src->ind_read, 1, pending, dst) == -1) {
+            return -1;
+        }
+        src->ind_read += pending;
+        copied = pending;
+    }
+    if (flush_buffer(dst) == -1 || direct_settle(dst) == -1) {
+        return -1;
+    }
+    if (len >= 0 && copied == len) {
+        return copied;
+    }
+
+    // Le reste ne quitte pas le noyau. Un fichier projeté est lu à sa
+    // position courante sans déplacer le descripteur. La lecture anticipée
+    // est suspendue (le descripteur doit revenir à l'appelant) puis relancée
+    // à la nouvelle position : le tampon de src est vide à ce stade.
+    int readahead = src->readahead != NULL;
+    if (readahead) {
+        readahead_stop(src);
+    }
+    loff_t map_pos = src->map_pos;
+    int restore_src = suspend_direct(src);
+    int restore_dst = suspend_direct(dst);
+    long result = kernel_copy(dst->fd, src->fd, src->map ? &map_pos : NULL, len < 0 ? -1 : len - copied);
+    if (restore_src) {
+        set_direct(src, 1);
+    }
+    if (restore_dst) {
+        set_direct(dst, 1);
+    }
+    if (result < 0) {
+        mini_perror("Error copying file");
+        if (readahead) {
+            freadahead_unlocked(src, 1);
+        }
+        return -1;
+    }
+    if (src->map) {
+        src->map_pos = map_pos;
+    } else {
+        src->offset += result;
+    }
+    if (readahead) {
+        freadahead_unlocked(src, 1); // En cas d'échec, src reste simplement sans lecture anticipée
+    }
+    dst->offset += result;
+    dst->handed += result; // Copié par le noyau : à rendre durable comme une écriture
+    return copied + result;
+}
+
+long mini_fcopy(MYFILE* dst, MYFILE* src, long len) {
+    if (!dst || !src || dst == src) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Verrous pris dans un ordre fixe pour éviter l'interblocage
+    MYFILE* first = dst < src ? dst : src;
+    MYFILE* second = dst < src ? src : dst;
+    mini_flockfile(first);
+    mini_flockfile(second);
+    long result = fcopy_unlocked(dst, src, len);
+    mini_funlockfile(second);
+    mini_funlockfile(first);
+    return result;
+}
+
+// Compteurs cumulés des flux fermés, pour le bilan de mini_exit_flush
+static mini_iostats closed_stats;
+static long closed_streams = 0;
+static int stats_report = 0;
+static pthread_mutex_t closed_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// mini_iostats ne contient que des long : addition champ par champ
+static void stats_add(mini_iostats* total, const mini_iostats* stats) {
+    long* dest = (long*)total;
+    const long* src = (const long*)stats;
+    for (int i = 0; i < (int)(sizeof(mini_iostats) / sizeof(long)); i++) {
+        dest[i] += src[i];
+    }
+}
+
+int mini_fstats(MYFILE* file, mini_iostats* stats) {
+    if (!file || !stats) {
+        errno = EINVAL;
+        return -1;
+    }
+    mini_flockfile(file);
+    *stats = file->stats;
+    mini_funlockfile(file);
+    stats->syncs = sync_count(file);
+    return 0;
+}
+
+void mini_fstats_report(int enable) {
+    stats_report = enable;
+}
+
+// « hits/requests » en pourcentage avec une décimale
+static void append_percent(mini_strbuf* sb, long hits, long requests) {
+    long permille = requests > 0 ? hits * 1000 / requests : 0;
+    mini_strbuf_append_int(sb, permille / 10);
+    mini_strbuf_append_char(sb, '.');
+    mini_strbuf_append_int(sb, permille % 10);
+    mini_strbuf_append_char(sb, '%');
+}
+
+static void append_histogram(mini_strbuf* sb, char* name, const long* histogram) {
+    mini_strbuf_append_str(sb, name);
+    for (int i = 0; i < MINI_STATS_BUCKETS; i++) {
+        if (histogram[i] > 0) {
+            mini_strbuf_append_str(sb, " 2^");
+            mini_strbuf_append_int(sb, i);
+            mini_strbuf_append_char(sb, ':');
+            mini_strbuf_append_int(sb, histogram[i]);
+        }
+    }
+    mini_strbuf_append_char(sb, '\n');
+}
+
+// Bilan de tous les flux, ouverts ou fermés, sur la sortie d'erreur
+static void stats_write_report(void) {
+    pthread_mutex_lock(&closed_stats_lock);
+    mini_iostats total = closed_stats;
+    long streams = closed_streams;
+    pthread_mutex_unlock(&closed_stats_lock);
+    pthread_mutex_lock(&open_files_lock);
+    for (int fd = 0; fd < open_files_capacity; fd++) {
+        if (open_files[fd]) {
+            stats_add(&total, &open_files[fd]->stats);
+            total.syncs += sync_count(open_files[fd]);
+            streams++;
+        }
+    }
+    pthread_mutex_unlock(&open_files_lock);
+
+    mini_strbuf sb;
+    mini_strbuf_init(&sb);
+    mini_strbuf_append_str(&sb, "mini_io stats, ");
+    mini_strbuf_append_int(&sb, streams);
+    mini_strbuf_append_str(&sb, " streams\n  read: ");
+    mini_strbuf_append_int(&sb, total.bytes_read);
+    mini_strbuf_append_str(&sb, " bytes in ");
+    mini_strbuf_append_int(&sb, total.read_calls);
+    mini_strbuf_append_str(&sb, " calls (");
+    mini_strbuf_append_int(&sb, total.short_reads);
+    mini_strbuf_append_str(&sb, " short), ");
+    append_percent(&sb, total.read_hits, total.read_requests);
+    mini_strbuf_append_str(&sb, " of requests served by the buffer\n  write: ");
+    mini_strbuf_append_int(&sb, total.bytes_written);
+    mini_strbuf_append_str(&sb, " bytes in ");
+    mini_strbuf_append_int(&sb, total.write_calls);
+    mini_strbuf_append_str(&sb, " calls, flushes: ");
+    mini_strbuf_append_int(&sb, total.flushes);
+    mini_strbuf_append_str(&sb, ", ");
+    append_percent(&sb, total.write_hits, total.write_requests);
+    mini_strbuf_append_str(&sb, " of requests absorbed by the buffer, syncs: ");
+    mini_strbuf_append_int(&sb, total.syncs);
+    mini_strbuf_append_char(&sb, '\n');
+    append_histogram(&sb, "  read latency (ns, log2 buckets):", total.read_latency);
+    append_histogram(&sb, "  write latency (ns, log2 buckets):", total.write_latency);
+    mini_strbuf_fwrite(&sb, mini_stderr);
+    mini_strbuf_free(&sb);
+}
+
 int mini_fclose(MYFILE* file) {
     if (!file) return -1;
+    if (is_std_stream(file)) {
+        return mini_fflush(file) == -1 ? -1 : 0; // Restent ouverts
+    }
+
+    // Verrou gardé jusqu'à la libération : mini_exit_flush ne vide un flux
+    // de la liste qu'après l'avoir verrouillé
+    mini_flockfile(file);
+    int result = 0; // Une erreur après le vidage n'empêche pas la libération
 
     // Flusher les données restantes
     if (file->buffer_write && file->ind_write > 0) {
         if (mini_fflush(file) == -1) {
+            mini_funlockfile(file);
             return -1;
         }
     }
 
+    if (file->mem) {
+        mem_close(file);
+    } else if (file->map) {
+        munmap(file->map, file->map_len);
+    }
+    if (file->mapw && mapw_close(file) == -1) {
+        mini_perror("Error truncating mapped file");
+        result = -1; // Le fichier garde le remplissage de la dernière tranche
+    }
+    if (file->readahead) {
+        readahead_stop(file); // Avant close : le thread lit encore le descripteur
+    }
+    if (file->lz) {
+        if (file->mode == 'Z' && lz_finish(file) == -1) {
+            mini_perror("Error writing compressed index");
+            result = -1;
+        }
+        lz_free(file);
+    }
+    if (file->sync) {
+        // Quel que soit l'intervalle, tout est durable à la fermeture
+        SyncState* sync = (SyncState*)file->sync;
+        if (sync->mode != MINI_SYNC_NONE && sync->synced < file->handed
+            && sync_data(file->fd, sync, file->handed) == -1) {
+            mini_perror("Error syncing file");
+            result = -1; // La durabilité promise n'est pas acquise
+        }
+        file->stats.syncs = sync->syncs;
+        pthread_mutex_destroy(&sync->lock);
+        pthread_cond_destroy(&sync->cond);
+        mini_free(sync);
+        file->sync = NULL;
+    }
+
     // Fermer le fichier
     if (file->fd != -1) {
         close(file->fd);
     }
 
     // Libérer les tampons et la structure
-    if (file->buffer_read) {
-        mini_free(file->buffer_read);
-    }
-    if (file->buffer_write) {
-        mini_free(file->buffer_write);
-    }
+    release_buffers(file);
+    mini_strbuf_free(&file->line);
     remove_open_file(file); // Retirer de la liste des fichiers ouverts
+    pthread_mutex_lock(&closed_stats_lock);
+    stats_add(&closed_stats, &file->stats);
+    closed_streams++;
+    pthread_mutex_unlock(&closed_stats_lock);
+    mini_funlockfile(file); // Plus accessible par la liste des flux à vider
     mini_free(file);
 
-    return 0;
+    return result;
 }
 
 void mini_exit_flush() {
-    OpenFile* current = open_files;  // Parcours de la liste des fichiers ouverts
-
-    while (current) {
-        MYFILE* file = current->file;
-
-        // Si le tampon d'écriture contient des données non écrites, les flusher
-        if (file && file->buffer_write && file->ind_write > 0) {
-            int result = mini_fflush(file);  // Flusher le tampon d'écriture
-            if (result == -1) {
-                mini_perror("Error flushing buffer on exit");
+    // Seuls les flux avec des écritures en attente sont parcourus
+    // Chaque flux est verrouillé avant de relâcher la liste : mini_fclose ne
+    // peut pas le libérer pendant le vidage. Il est retiré de la liste ici,
+    // même si le vidage échoue, pour ne jamais le reprendre. Un flux tenu par
+    // un autre thread est sauté, puis retenté un nombre limité de fois.
+    int busy_passes = 0;
+    pthread_mutex_lock(&dirty_files_lock);
+    MYFILE* file = dirty_files;
+    while (file) {
+        if (mini_ftrylockfile(file) == -1) {
+            file = file->dirty_next;
+            if (!file && ++busy_passes < EXIT_FLUSH_RETRIES) {
+                pthread_mutex_unlock(&dirty_files_lock);
+                sched_yield();
+                pthread_mutex_lock(&dirty_files_lock);
+                file = dirty_files;
             }
+            continue;
         }
-
-        // Passer au fichier suivant dans la liste
-        current = current->next;
+        unlink_dirty(file);
+        pthread_mutex_unlock(&dirty_files_lock);
+        if (mini_fflush(file) == -1) {
+            mini_perror("Error flushing buffer on exit");
+        }
+        // Mode 'M' non fermé : le fichier garde sinon sa tranche creuse
+        if (file->mapw && mapw_trim(file) == -1) {
+            mini_perror("Error flushing buffer on exit");
+        }
+        mini_funlockfile(file);
+        pthread_mutex_lock(&dirty_files_lock);
+        file = dirty_files;
+    }
+    pthread_mutex_unlock(&dirty_files_lock);
+    if (stats_report) {
+        stats_write_report();
     }
 }
 
@@ -1,13 +1,105 @@
 #ifndef MINI_LIB_H
 #define MINI_LIB_H
 
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Politiques de durabilité de mini_fsetsync
+#define MINI_SYNC_NONE 0        // mini_fflush s'arrête au noyau
+#define MINI_SYNC_FLUSH 1       // fdatasync à chaque mini_fflush
+#define MINI_SYNC_PERIODIC 2    // fdatasync au plus une fois par intervalle
+#define MINI_SYNC_GROUP 3       // les mini_fflush concurrents partagent un fdatasync
+
+// Modes de tampon de mini_setvbuf
+#define MINI_IOFBF 0    // tampon complet
+#define MINI_IOLBF 1    // vidé à chaque fin de ligne écrite
+#define MINI_IONBF 2    // pas de tampon
+
+// Tampon d'octets extensible, doublé à la demande
 typedef struct {
+    char* data;
+    int len;
+    int capacity;
+} mini_strbuf;
+
+// Compteurs d'un flux (mini_fstats). Latences en nanosecondes, en échelle
+// logarithmique : le seau i compte les appels système de durée [2^i, 2^(i+1))
+#define MINI_STATS_BUCKETS 32
+typedef struct {
+    long bytes_read;        // octets rendus par les appels système de lecture
+    long bytes_written;     // octets acceptés par les appels système d'écriture (ou la projection, mode 'M')
+    long read_calls;        // read, readv, pread (y compris ceux du thread de lecture anticipée)
+    long write_calls;       // write, writev, pwrite
+    long short_reads;       // lectures qui ont rendu moins que demandé (fin de fichier comprise)
+    long flushes;           // vidages d'un tampon d'écriture non vide
+    long syncs;             // fdatasync demandés par la politique de durabilité (mini_fsetsync)
+    long read_requests;     // appels à mini_fread et mini_fgetline
+    long read_hits;         // ... servis sans appel système
+    long write_requests;    // appels à mini_fwrite
+    long write_hits;        // ... absorbés par le tampon
+    long read_latency[MINI_STATS_BUCKETS];
+    long write_latency[MINI_STATS_BUCKETS];
+} mini_iostats;
+
+typedef struct MYFILE {
     int fd;
+    char mode;      // mode passé à mini_fopen
     void * buffer_read;
     void * buffer_write;
-    int ind_read;
+    int ind_read;   // prochain octet à consommer dans buffer_read
+    int end_read;   // fin des données valides dans buffer_read
     int ind_write;
+    int buffer_size;    // taille de chaque tampon
+    int buffer_mode;    // MINI_IOFBF, MINI_IOLBF ou MINI_IONBF
+    int user_buffers;   // 1 si les tampons appartiennent à l'appelant
+    char * map;         // projection du fichier (mode 'm'), NULL sinon
+    long map_len;       // taille de la projection
+    long map_pos;       // position de lecture dans la projection
+    long offset;        // position du descripteur après nos appels système
+    long read_base;     // position dans le fichier de buffer_read[0]
+    void * readahead;   // état de la lecture anticipée, NULL si désactivée
+    mini_strbuf line;   // ligne à cheval sur deux tampons (mini_fgetline)
+    int lock_state;     // verrou du flux : 0 libre, 1 pris, 2 pris avec attente
+    int lock_count;     // profondeur de verrouillage du propriétaire
+    void * lock_owner;  // thread qui détient le verrou
+    int dirty;          // 1 si dans la liste des flux à vider (écritures en attente)
+    struct MYFILE * dirty_prev;
+    struct MYFILE * dirty_next;
+    int direct;         // 1 si ouvert en O_DIRECT (modes 'd' et 'D') : tampons alignés
+    void * lz;          // état de la compression par blocs (modes 'z' et 'Z'), NULL sinon
+    mini_iostats stats;
+    void * sync;        // politique de durabilité (mini_fsetsync), NULL si aucune
+    void * mapw;        // écriture projetée (mode 'M'), NULL sinon
+    void * mem;         // flux en mémoire (mini_fmemopen), NULL sinon
+    long handed;        // octets confiés au noyau (écritures, copies noyau, projection) : durabilité
 } MYFILE;
+
+// Recherche de plusieurs motifs (automate d'Aho-Corasick, une transition par octet)
+typedef struct {
+    int* next;          // state_count * 256 transitions
+    int* output;        // premier motif qui finit à chaque état, -1 sinon
+    int* duplicate;     // motif suivant de même texte, -1 sinon
+    int* output_link;   // état suivant sur la chaîne d'échec qui a une sortie
+    int* lengths;       // longueur de chaque motif
+    int state_count;
+    int pattern_count;
+} MINI_AC;
+
+// Vue sans propriété sur une plage d'octets (sans '\0' final)
+typedef struct {
+    const char* data;
+    int len;
+} mini_strview;
+
+// Découpe une vue sur un ensemble de délimiteurs, sans copie ni écriture
+typedef struct {
+    mini_strview rest;
+    unsigned char delims[32];   // un bit par octet délimiteur
+} mini_tokenizer;
+
 //mini_memory.c
 extern void* mini_memset(void *ptr, int value, int num);
 extern void* mini_calloc(int size_element, int number_element);
@@ -15,6 +107,7 @@ extern void mini_free(void *ptr);
 extern void mini_exit();
 //mini_string.c
 extern void mini_printf(char *str);
+extern void mini_printf_n(const char *str, int len);
 extern void mini_exit_printf();
 extern int mini_scanf(char* buffer, int size_buffer);
 extern int mini_strlen(char* s);
@@ -22,16 +115,132 @@ extern int mini_strcopy(char* s, char *d);
 extern int mini_strcmp(char* s1, char* s2);
 extern void mini_perror(char * message);
 //mini_io.c
+// Entrée, sortie et erreur standard (la sortie est tamponnée par ligne sur un
+// terminal, complètement sinon ; l'erreur ne l'est pas). mini_fclose les vide
+// sans les fermer.
+extern MYFILE* mini_stdin;
+extern MYFILE* mini_stdout;
+extern MYFILE* mini_stderr;
 extern void add_open_file(MYFILE* file);
 extern void remove_open_file(MYFILE* file);
 extern MYFILE* mini_fopen(char* file, char mode);
+// Flux sur len octets en mémoire, sans appel système. Modes 'r', 'w' (le
+// contenu de buf est ignoré) et 'b' (lecture et écriture). buf NULL : tampon
+// géré par la bibliothèque, agrandi à la demande. Les données sont
+// accessibles sans copie par mini_fmap_view.
+extern MYFILE* mini_fmemopen(void* buf, long len, char mode);
+extern int mini_setvbuf(MYFILE* file, char* buf, int mode, int size);
+extern int mini_freadahead(MYFILE* file, int enable);
 extern void* mini_memcpy(void* dest, const void* src, int n);
 extern void* mini_memmove(void* dest, const void* src, int n);
+// Données d'un flux 'm' ou en mémoire ; un flux en mémoire peut les
+// déplacer en s'agrandissant (valide jusqu'à la prochaine écriture)
+extern char* mini_fmap_view(MYFILE* file, long* len);
+// Chaque appel verrouille le flux ; les variantes _unlocked supposent que
+// l'appelant le détient déjà (mini_flockfile) ou que le flux n'est pas partagé
+extern void mini_flockfile(MYFILE* file);
+extern int mini_ftrylockfile(MYFILE* file);
+extern void mini_funlockfile(MYFILE* file);
 extern int mini_fread(void* buffer, int size_element, int number_element, MYFILE* file);
+extern int mini_fread_unlocked(void* buffer, int size_element, int number_element, MYFILE* file);
+// Ligne suivante ('\n' compris, sans '\0'), valide jusqu'à la prochaine lecture
+extern char* mini_fgetline(MYFILE* file, int* len);
+extern char* mini_fgetline_unlocked(MYFILE* file, int* len);
 extern int mini_fwrite(void* buffer, int size_element, int number_element, MYFILE* file);
+extern int mini_fwrite_unlocked(void* buffer, int size_element, int number_element, MYFILE* file);
+extern int mini_fwritev(MYFILE* file, const struct iovec* iov, int iovcnt);
+extern int mini_freadv(MYFILE* file, const struct iovec* iov, int iovcnt);
+extern long mini_ftell(MYFILE* file);
+extern int mini_fseek(MYFILE* file, long offset, int whence);
+extern int mini_fpread(MYFILE* file, void* buffer, int size, long offset);
+extern int mini_fpwrite(MYFILE* file, void* buffer, int size, long offset);
 extern int mini_fflush(MYFILE* file);
+extern int mini_fflush_unlocked(MYFILE* file);
+// Tampons du flux vidés avant une E/S hors tampon ; la position avance de
+// advance octets, retourne celle d'avant (utilisé par mini_async.c)
+extern long mini_fhandoff(MYFILE* file, long advance);
+// Durabilité des mini_fflush du flux (MINI_SYNC_*). interval_us : écart
+// minimal entre deux fdatasync en mode périodique, fenêtre de regroupement
+// en mode groupe ; mini_fclose synchronise toujours ce qui reste.
+extern int mini_fsetsync(MYFILE* file, int mode, int interval_us);
+// Copie len octets (len < 0 : jusqu'à la fin) de src vers dst sans passer
+// par l'espace utilisateur ; retourne le nombre d'octets copiés
+extern long mini_fcopy(MYFILE* dst, MYFILE* src, long len);
+// Flux 'z' : nombre de blocs et lecture d'un bloc sans toucher à la position
+// du flux (appelable depuis plusieurs threads sur des blocs différents)
+extern int mini_fzblocks(MYFILE* file);
+extern int mini_fzread_block(MYFILE* file, int block, void* dest, int capacity);
+// Copie les compteurs du flux dans stats
+extern int mini_fstats(MYFILE* file, mini_iostats* stats);
+// Active le bilan de tous les flux (ouverts et fermés) écrit sur la sortie
+// d'erreur par mini_exit_flush
+extern void mini_fstats_report(int enable);
 extern int mini_fclose(MYFILE* file);
 extern void mini_exit_flush();
+//mini_async.c
+// Requêtes asynchrones hors tampon du flux. La préparation vide les tampons
+// du flux ; offset < 0 : position logique du flux, qui avance alors de size.
+// Les requêtes préparées partent ensemble au prochain mini_async_submit ;
+// l'API est prévue pour un seul thread émetteur.
+#define MINI_AIO_AUTO 0
+#define MINI_AIO_URING 1
+#define MINI_AIO_THREADS 2
+extern int mini_async_init(int depth, int backend);
+extern void mini_async_shutdown(void);
+extern int mini_fread_async(MYFILE* file, void* buffer, int size, long offset);
+extern int mini_fwrite_async(MYFILE* file, void* buffer, int size, long offset);
+extern int mini_async_submit(void);
+extern int mini_async_complete(int* id, int* result, int wait);
+//mini_search.c
+extern int mini_memcmp(const void* s1, const void* s2, int n);
+extern void* mini_memchr(const void* s, int c, int n);
+extern void* mini_memmem(const void* haystack, int haystack_len, const void* needle, int needle_len);
+extern char* mini_strstr(char* haystack, char* needle);
+extern MINI_AC* mini_ac_new(char** patterns, int count);
+extern int mini_ac_scan(MINI_AC* ac, const void* buffer, int len,
+                        int (*on_match)(int pattern, int start, void* ctx), void* ctx);
+extern void mini_ac_free(MINI_AC* ac);
+//mini_strview.c
+extern mini_strview mini_sv(const char* s);
+extern mini_strview mini_sv_from(const char* data, int len);
+extern mini_strview mini_sv_sub(mini_strview sv, int start, int len);
+extern mini_strview mini_sv_trim_left(mini_strview sv);
+extern mini_strview mini_sv_trim_right(mini_strview sv);
+extern mini_strview mini_sv_trim(mini_strview sv);
+extern int mini_sv_find_char(mini_strview sv, char c);
+extern int mini_sv_find(mini_strview sv, mini_strview needle);
+extern int mini_sv_cmp(mini_strview a, mini_strview b);
+extern int mini_sv_equals(mini_strview a, char* s);
+extern int mini_sv_starts_with(mini_strview sv, mini_strview prefix);
+extern int mini_sv_split(mini_strview sv, char delim, mini_strview* head, mini_strview* tail);
+extern int mini_sv_to_int(mini_strview sv, int* value);
+extern void mini_tok_init(mini_tokenizer* tok, mini_strview sv, char* delims);
+extern int mini_tok_next(mini_tokenizer* tok, mini_strview* token);
+//mini_strbuf.c
+extern void mini_strbuf_init(mini_strbuf* sb);
+extern int mini_strbuf_reserve(mini_strbuf* sb, int extra);
+extern int mini_strbuf_append(mini_strbuf* sb, const void* data, int len);
+extern int mini_strbuf_append_str(mini_strbuf* sb, char* s);
+extern int mini_strbuf_append_char(mini_strbuf* sb, char c);
+extern int mini_strbuf_append_int(mini_strbuf* sb, long value);
+extern char* mini_strbuf_cstr(mini_strbuf* sb);
+extern void mini_strbuf_clear(mini_strbuf* sb);
+extern void mini_strbuf_free(mini_strbuf* sb);
+extern int mini_strbuf_fwrite(mini_strbuf* sb, MYFILE* file);
+extern struct iovec mini_strbuf_iov(mini_strbuf* sb);
+//mini_lz.c
+extern int mini_lz_bound(int len);
+extern int mini_lz_compress(const void* src, int len, void* dst, int capacity);
+extern int mini_lz_decompress(const void* src, int len, void* dst, int capacity);
+//mini_utf8.c
+extern int mini_utf8_validate(const void* s, int len);
+extern int mini_utf8_count(const void* s, int len);
+extern int mini_utf8_width(const void* s, int len);
+extern int mini_utf8_truncate(const void* s, int len, int max_width);
+
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif // MINI_LIB_H
\ No newline at end of file
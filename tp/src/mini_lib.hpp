@@ -0,0 +1,225 @@
+/**
+ * @file mini_lib.hpp
+ * @brief C++20 front-end for mini_lib with compile-time format strings.
+ *
+ * The format string is a template argument, so it is parsed once by the
+ * compiler into a fixed list of segments. Each call then emits the literal
+ * pieces and the formatted arguments in order, with no parsing at run time:
+ *
+ *     mini::print<"%s: %d files, mask %x\n">(name, count, mask);
+ *     mini::format_to<"%d%c">(strbuf, value, '\n');
+ *
+ * Supported conversions: %d (signed integer), %u (unsigned integer),
+ * %x (integer, hexadecimal), %c (char), %s (char*, const char* or
+ * mini_strview) and %%. A wrong conversion, a wrong argument type or a
+ * wrong number of arguments is a compile error.
+ */
+#ifndef MINI_LIB_HPP
+#define MINI_LIB_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mini_lib.h"
+
+namespace mini {
+
+// String literal usable as a template argument
+template <std::size_t N>
+struct fixed_string {
+    char data[N];
+    constexpr fixed_string(const char (&s)[N]) {
+        for (std::size_t i = 0; i < N; i++) data[i] = s[i];
+    }
+    constexpr std::size_t size() const { return N - 1; }
+};
+
+enum class conv : char { literal, dec, udec, hex, chr, str };
+
+struct segment {
+    conv kind;
+    int begin;   // literal segments only: offset in the format string
+    int len;
+};
+
+namespace detail {
+
+constexpr conv conversion_of(char c) {
+    switch (c) {
+        case 'd': return conv::dec;
+        case 'u': return conv::udec;
+        case 'x': return conv::hex;
+        case 'c': return conv::chr;
+        case 's': return conv::str;
+        default: throw "mini::print: unsupported conversion in format string";
+    }
+}
+
+// Calls f(segment) for each segment of the format, "%%" being a literal '%'
+template <fixed_string F, typename Fn>
+constexpr void for_each_segment(Fn f) {
+    int start = 0;
+    int n = (int)F.size();
+    for (int i = 0; i < n; i++) {
+        if (F.data[i] != '%') continue;
+        if (i + 1 >= n) throw "mini::print: format string ends with '%'";
+        if (F.data[i + 1] == '%') {
+            f(segment{conv::literal, start, i + 1 - start});
+            start = i + 2;
+        } else {
+            if (i > start) f(segment{conv::literal, start, i - start});
+            f(segment{conversion_of(F.data[i + 1]), 0, 0});
+            start = i + 2;
+        }
+        i++;
+    }
+    if (n > start) f(segment{conv::literal, start, n - start});
+}
+
+template <fixed_string F>
+constexpr int segment_count() {
+    int count = 0;
+    for_each_segment<F>([&](segment) { count++; });
+    return count;
+}
+
+template <fixed_string F>
+constexpr int argument_count() {
+    int count = 0;
+    for_each_segment<F>([&](segment s) { count += s.kind != conv::literal; });
+    return count;
+}
+
+template <fixed_string F>
+struct parsed {
+    static constexpr int count = segment_count<F>();
+    struct table {
+        segment seg[count > 0 ? count : 1];
+        int arg[count > 0 ? count : 1];   // argument index of each conversion
+    };
+    static constexpr table value = [] {
+        table t{};
+        int i = 0, a = 0;
+        for_each_segment<F>([&](segment s) {
+            t.seg[i] = s;
+            t.arg[i] = s.kind == conv::literal ? -1 : a++;
+            i++;
+        });
+        return t;
+    }();
+};
+
+template <typename T>
+using bare = std::remove_cvref_t<T>;
+
+template <typename T>
+constexpr bool is_number = std::is_integral_v<bare<T>> && !std::is_same_v<bare<T>, bool>
+                           && !std::is_same_v<bare<T>, char>;
+
+template <typename T>
+constexpr bool is_text = std::is_same_v<std::decay_t<T>, char*> || std::is_same_v<std::decay_t<T>, const char*>
+                         || std::is_same_v<bare<T>, mini_strview>;
+
+template <conv C, typename T>
+constexpr bool accepts() {
+    if constexpr (C == conv::dec) return is_number<T> && std::is_signed_v<bare<T>>;
+    else if constexpr (C == conv::udec) return is_number<T> && std::is_unsigned_v<bare<T>>;
+    else if constexpr (C == conv::hex) return is_number<T>;
+    else if constexpr (C == conv::chr) return std::is_same_v<bare<T>, char>;
+    else if constexpr (C == conv::str) return is_text<T>;
+    else return false;
+}
+
+// Writes the digits of value so that they end at end, returns the first digit
+inline char* format_unsigned(unsigned long long value, unsigned base, char* end) {
+    char* p = end;
+    do {
+        *--p = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value);
+    return p;
+}
+
+template <conv C, typename Sink, typename T>
+inline void emit(Sink& sink, const T& value) {
+    if constexpr (C == conv::chr) {
+        sink(&value, 1);
+    } else if constexpr (C == conv::str) {
+        if constexpr (std::is_same_v<bare<T>, mini_strview>) {
+            sink(value.data, value.len);
+        } else if constexpr (std::is_array_v<bare<T>>) {
+            sink(value, mini_strlen(const_cast<char*>(value)));
+        } else if (value != nullptr) {
+            sink(value, mini_strlen(const_cast<char*>(value)));
+        }
+    } else {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p;
+        if constexpr (C == conv::dec) {
+            long long v = value;
+            unsigned long long magnitude = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+            p = format_unsigned(magnitude, 10, end);
+            if (v < 0) *--p = '-';
+        } else if constexpr (C == conv::udec) {
+            p = format_unsigned((unsigned long long)value, 10, end);
+        } else {
+            p = format_unsigned((unsigned long long)(std::make_unsigned_t<bare<T>>)value, 16, end);
+        }
+        sink(p, (int)(end - p));
+    }
+}
+
+template <int I, typename T, typename... Rest>
+constexpr const auto& nth(const T& first, const Rest&... rest) {
+    if constexpr (I == 0) return first;
+    else return nth<I - 1>(rest...);
+}
+
+template <fixed_string F, int I, typename Sink, typename... Args>
+inline void emit_segment(Sink& sink, const Args&... args) {
+    constexpr segment s = parsed<F>::value.seg[I];
+    if constexpr (s.kind == conv::literal) {
+        sink(F.data + s.begin, s.len);
+    } else {
+        constexpr int a = parsed<F>::value.arg[I];
+        using T = std::tuple_element_t<a, std::tuple<Args...>>;
+        static_assert(accepts<s.kind, T>(), "mini::print: argument type does not match its conversion");
+        emit<s.kind>(sink, nth<a>(args...));
+    }
+}
+
+template <fixed_string F, typename Sink, typename... Args, int... I>
+inline void emit_all(Sink& sink, std::integer_sequence<int, I...>, const Args&... args) {
+    (emit_segment<F, I>(sink, args...), ...);
+}
+
+}  // namespace detail
+
+// Formats into the mini_printf buffer
+template <fixed_string F, typename... Args>
+inline void print(const Args&... args) {
+    static_assert(detail::argument_count<F>() == sizeof...(Args),
+                  "mini::print: argument count does not match the format string");
+    auto sink = [](const char* s, int len) { mini_printf_n(s, len); };
+    detail::emit_all<F>(sink, std::make_integer_sequence<int, detail::parsed<F>::count>{}, args...);
+}
+
+// Appends the formatted text to a mini_strbuf, returns -1 on allocation failure
+template <fixed_string F, typename... Args>
+inline int format_to(mini_strbuf& sb, const Args&... args) {
+    static_assert(detail::argument_count<F>() == sizeof...(Args),
+                  "mini::format_to: argument count does not match the format string");
+    int status = 0;
+    auto sink = [&](const char* s, int len) {
+        if (mini_strbuf_append(&sb, s, len) < 0) status = -1;
+    };
+    detail::emit_all<F>(sink, std::make_integer_sequence<int, detail::parsed<F>::count>{}, args...);
+    return status;
+}
+
+}  // namespace mini
+
+#endif // MINI_LIB_HPP
@@ -0,0 +1,229 @@
+//include standart library
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//include personal library
+#include "mini_lib.h"
+
+// Format d'un bloc : une suite de groupes (jeton, littéraux, correspondance).
+//   jeton   quartet haut : nombre de littéraux, quartet bas : longueur - 4
+//           (15 dans un quartet : des octets de longueur suivent, 255 = encore)
+//   offset  2 octets petit-boutistes, distance jusqu'au début de la correspondance
+// Le dernier groupe n'a que des littéraux et pas d'offset : le bloc s'arrête là.
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 13
+#define LZ_MAX_OFFSET 65535
+#define LZ_LAST_LITERALS 5  // aucune correspondance ne commence dans les derniers octets d'un bloc
+
+static unsigned int read32(const unsigned char* p) {
+    return (unsigned int)p[0] | (unsigned int)p[1] << 8 | (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+static unsigned int hash32(unsigned int v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Écrit la suite d'une longueur (valeur déjà diminuée de 15), retourne la
+// nouvelle position de sortie ou NULL si elle ne tient pas
+static unsigned char* put_length(unsigned char* op, unsigned char* end, int value) {
+    while (value >= 255) {
+        if (op >= end) {
+            return NULL;
+        }
+        *op++ = 255;
+        value -= 255;
+    }
+    if (op >= end) {
+        return NULL;
+    }
+    *op++ = (unsigned char)value;
+    return op;
+}
+
+int mini_lz_bound(int len) {
+    return len + len / 255 + 16;
+}
+
+int mini_lz_compress(const void* src, int len, void* dst, int capacity) {
+    if (src == NULL || dst == NULL || len < 0 || capacity <= 0) {
+        return -1;
+    }
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* end = op + capacity;
+    int table[1 << LZ_HASH_BITS];
+    for (int i = 0; i < (1 << LZ_HASH_BITS); i++) {
+        table[i] = -1;
+    }
+
+    int ip = 0, anchor = 0;
+    int limit = len - LZ_LAST_LITERALS;
+    while (ip < limit) {
+        unsigned int sequence = read32(in + ip);
+        unsigned int h = hash32(sequence);
+        int ref = table[h];
+        table[h] = ip;
+        if (ref < 0 || ip - ref > LZ_MAX_OFFSET || read32(in + ref) != sequence) {
+            // Données incompressibles : le pas grandit tant que rien ne correspond
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        // Prolonge la correspondance vers l'avant, et vers l'arrière sur les littéraux en attente
+        int match = LZ_MIN_MATCH;
+        while (ip + match < limit && in[ref + match] == in[ip + match]) {
+            match++;
+        }
+        while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+            ip--;
+            ref--;
+            match++;
+        }
+
+        int literals = ip - anchor;
+        if (op + 1 + literals + 2 > end) {
+            return -1;
+        }
+        unsigned char* token = op++;
+        *token = (unsigned char)((literals < 15 ? literals : 15) << 4);
+        if (literals >= 15 && !(op = put_length(op, end, literals - 15))) {
+            return -1;
+        }
+        if (op + literals + 2 > end) {
+            return -1;
+        }
+        mini_memcpy(op, in + anchor, literals);
+        op += literals;
+        int offset = ip - ref;
+        *op++ = (unsigned char)offset;
+        *op++ = (unsigned char)(offset >> 8);
+        int extra = match - LZ_MIN_MATCH;
+        *token |= (unsigned char)(extra < 15 ? extra : 15);
+        if (extra >= 15 && !(op = put_length(op, end, extra - 15))) {
+            return -1;
+        }
+        ip += match;
+        anchor = ip;
+        if (ip - 2 >= 0 && ip - 2 < limit) {
+            table[hash32(read32(in + ip - 2))] = ip - 2;
+        }
+    }
+
+    // Littéraux de fin
+    int literals = len - anchor;
+    if (op + 1 > end) {
+        return -1;
+    }
+    unsigned char* token = op++;
+    *token = (unsigned char)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15 && !(op = put_length(op, end, literals - 15))) {
+        return -1;
+    }
+    if (op + literals > end) {
+        return -1;
+    }
+    mini_memcpy(op, in + anchor, literals);
+    op += literals;
+    return (int)(op - (unsigned char*)dst);
+}
+
+// Copie n octets par pas de 16 et peut écrire jusqu'à 15 octets après n :
+// l'appelant vérifie que les deux côtés ont cette marge
+static void wild_copy(unsigned char* d, const unsigned char* s, int n) {
+    unsigned char* end = d + n;
+#ifdef __SSE2__
+    while (d < end) {
+        _mm_storeu_si128((__m128i*)d, _mm_loadu_si128((const __m128i*)s));
+        d += 16;
+        s += 16;
+    }
+#else
+    while (d < end) {
+        *d++ = *s++;
+    }
+#endif
+}
+
+// Lit la suite d'une longueur, retourne -1 si l'entrée s'arrête avant
+static int get_length(const unsigned char** ip, const unsigned char* end) {
+    int value = 0;
+    unsigned char byte;
+    do {
+        if (*ip >= end) {
+            return -1;
+        }
+        byte = *(*ip)++;
+        value += byte;
+    } while (byte == 255);
+    return value;
+}
+
+int mini_lz_decompress(const void* src, int len, void* dst, int capacity) {
+    if (src == NULL || dst == NULL || len <= 0 || capacity < 0) {
+        return -1;
+    }
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* in_end = ip + len;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* out_end = op + capacity;
+
+    while (1) {
+        if (ip >= in_end) {
+            return -1;
+        }
+        int token = *ip++;
+        int literals = token >> 4;
+        if (literals == 15) {
+            int extra = get_length(&ip, in_end);
+            if (extra < 0) {
+                return -1;
+            }
+            literals += extra;
+        }
+        if (literals > in_end - ip || literals > out_end - op) {
+            return -1;
+        }
+        if (in_end - ip >= literals + 16 && out_end - op >= literals + 16) {
+            wild_copy(op, ip, literals);
+        } else {
+            mini_memcpy(op, ip, literals);
+        }
+        op += literals;
+        ip += literals;
+        if (ip == in_end) {
+            break; // Dernier groupe : littéraux seulement
+        }
+
+        if (in_end - ip < 2) {
+            return -1;
+        }
+        int offset = ip[0] | ip[1] << 8;
+        ip += 2;
+        int match = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15) {
+            int extra = get_length(&ip, in_end);
+            if (extra < 0) {
+                return -1;
+            }
+            match += extra;
+        }
+        if (offset == 0 || offset > op - (unsigned char*)dst || match > out_end - op) {
+            return -1;
+        }
+        const unsigned char* ref = op - offset;
+        if (offset >= 16 && out_end - op >= match + 16) {
+            wild_copy(op, ref, match); // Chaque pas lit des octets déjà écrits
+            op += match;
+        } else if (offset >= match) {
+            mini_memcpy(op, ref, match);
+            op += match;
+        } else {
+            // Copie qui chevauche : répète les offset derniers octets
+            for (int i = 0; i < match; i++) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return (int)(op - (unsigned char*)dst);
+}
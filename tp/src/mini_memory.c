@@ -73,6 +73,7 @@ void mini_exit();
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 // include personal library
 #include "mini_lib.h"
@@ -86,6 +87,7 @@ struct malloc_element {
 };
 
 struct malloc_element *malloc_list = NULL;
+static pthread_mutex_t malloc_lock = PTHREAD_MUTEX_INITIALIZER; // Streams may allocate from several threads
 
 void* mini_memset(void *ptr, int value, int num) {
     // parameter validation
@@ -101,7 +103,7 @@ void* mini_memset(void *ptr, int value, int num) {
     return ptr;
 }
 
-void* mini_calloc(int size_element, int number_element) {
+static void* calloc_locked(int size_element, int number_element) {
     // parameter validation
     if (size_element <= 0 || number_element <= 0) {
         return NULL;
@@ -158,12 +160,20 @@ void* mini_calloc(int size_element, int number_element) {
     return memory;
 }
 
+void* mini_calloc(int size_element, int number_element) {
+    pthread_mutex_lock(&malloc_lock);
+    void* memory = calloc_locked(size_element, number_element);
+    pthread_mutex_unlock(&malloc_lock);
+    return memory;
+}
+
 void mini_free(void* ptr) {
     if (ptr == NULL) {
         printf("mini_free: NULL pointer, nothing to free.\n");
         return; // Do nothing if the pointer is NULL
     }
 
+    pthread_mutex_lock(&malloc_lock);
     struct malloc_element *current = malloc_list;
 
     // Traverse the list to find the element corresponding to the pointer
@@ -176,10 +186,12 @@ void mini_free(void* ptr) {
             } else {
                 printf("mini_free: Block at %p is already free.\n", ptr); // Message if the block is already free
             }
+            pthread_mutex_unlock(&malloc_lock);
             return; // Exit after finding and freeing the memory
         }
         current = current->next_malloc;
     }
+    pthread_mutex_unlock(&malloc_lock);
 
     // If we reach this point, it means the pointer was not found
     write(2, "mini_free: Error, pointer not allocated by mini_calloc\n", 54);
@@ -188,6 +200,5 @@ void mini_free(void* ptr) {
 void mini_exit()
 {
     mini_exit_flush();
-    mini_exit_printf();
     _exit(0);
 }
\ No newline at end of file
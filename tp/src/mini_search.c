@@ -0,0 +1,328 @@
+//include standart library
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//include personal library
+#include "mini_lib.h"
+
+// Octets vérifiés permis par octet parcouru avant que le préfiltre passe la
+// main à Two-Way (le pire cas reste linéaire)
+#define PREFILTER_BUDGET 16
+
+#define AC_ALPHABET 256
+
+int mini_memcmp(const void* s1, const void* s2, int n) {
+    const unsigned char* a = (const unsigned char*)s1;
+    const unsigned char* b = (const unsigned char*)s2;
+    for (int i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return a[i] - b[i];
+        }
+    }
+    return 0;
+}
+
+void* mini_memchr(const void* s, int c, int n) {
+    if (s == NULL || n <= 0) {
+        return NULL;
+    }
+    const unsigned char* p = (const unsigned char*)s;
+    unsigned char target = (unsigned char)c;
+    int i = 0;
+#ifdef __SSE2__
+    // Compare 16 octets à la fois à l'octet cherché
+    __m128i wanted = _mm_set1_epi8((char)target);
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, wanted));
+        if (mask) {
+            return (void*)(p + i + __builtin_ctz(mask));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (p[i] == target) {
+            return (void*)(p + i);
+        }
+    }
+    return NULL;
+}
+
+// Début du suffixe maximal de x (ordre inversé si reverse != 0) et sa période
+static int maximal_suffix(const unsigned char* x, int m, int* period, int reverse) {
+    int ms = -1, j = 0, k = 1, p = 1;
+    while (j + k < m) {
+        unsigned char a = x[j + k];
+        unsigned char b = x[ms + k];
+        if (reverse ? a > b : a < b) {
+            j += k;
+            k = 1;
+            p = j - ms;
+        } else if (a == b) {
+            if (k != p) {
+                k++;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            ms = j;
+            j = ms + 1;
+            k = p = 1;
+        }
+    }
+    *period = p;
+    return ms;
+}
+
+// Recherche Two-Way (Crochemore-Perrin) : temps linéaire, espace constant
+static const unsigned char* two_way(const unsigned char* y, int n, const unsigned char* x, int m) {
+    int p, q;
+    int i = maximal_suffix(x, m, &p, 0);
+    int j = maximal_suffix(x, m, &q, 1);
+    int ell = i > j ? i : j;
+    int per = i > j ? p : q;
+
+    if (mini_memcmp(x, x + per, ell + 1) == 0) {
+        // Motif périodique : on retient le préfixe déjà reconnu
+        int memory = -1;
+        j = 0;
+        while (j <= n - m) {
+            i = (ell > memory ? ell : memory) + 1;
+            while (i < m && x[i] == y[i + j]) {
+                i++;
+            }
+            if (i >= m) {
+                i = ell;
+                while (i > memory && x[i] == y[i + j]) {
+                    i--;
+                }
+                if (i <= memory) {
+                    return y + j;
+                }
+                j += per;
+                memory = m - per - 1;
+            } else {
+                j += i - ell;
+                memory = -1;
+            }
+        }
+    } else {
+        per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+        j = 0;
+        while (j <= n - m) {
+            i = ell + 1;
+            while (i < m && x[i] == y[i + j]) {
+                i++;
+            }
+            if (i >= m) {
+                i = ell;
+                while (i >= 0 && x[i] == y[i + j]) {
+                    i--;
+                }
+                if (i < 0) {
+                    return y + j;
+                }
+                j += per;
+            } else {
+                j += i - ell;
+            }
+        }
+    }
+    return NULL;
+}
+
+void* mini_memmem(const void* haystack, int haystack_len, const void* needle, int needle_len) {
+    if (haystack == NULL || needle == NULL || haystack_len < 0 || needle_len < 0) {
+        return NULL;
+    }
+    const unsigned char* h = (const unsigned char*)haystack;
+    const unsigned char* x = (const unsigned char*)needle;
+    if (needle_len == 0) {
+        return (void*)h;
+    }
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    if (needle_len == 1) {
+        return mini_memchr(h, x[0], haystack_len);
+    }
+
+    // Préfiltre sur le premier et le dernier octet : seules les positions où
+    // les deux correspondent sont vérifiées. Si la vérification coûte trop
+    // (motif très répétitif), Two-Way prend le relais pour la suite du texte.
+    int last = needle_len - 1;
+    int candidates = haystack_len - needle_len + 1;
+    long verified = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i first_byte = _mm_set1_epi8((char)x[0]);
+    __m128i last_byte = _mm_set1_epi8((char)x[last]);
+    for (; i + 16 <= candidates; i += 16) {
+        __m128i head = _mm_loadu_si128((const __m128i*)(h + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(h + i + last));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first_byte),
+                                                   _mm_cmpeq_epi8(tail, last_byte)));
+        while (mask) {
+            int pos = i + __builtin_ctz(mask);
+            if (mini_memcmp(h + pos + 1, x + 1, needle_len - 2) == 0) {
+                return (void*)(h + pos);
+            }
+            verified += needle_len;
+            mask &= mask - 1;
+        }
+        if (verified > (long)PREFILTER_BUDGET * (i + 16) + 1024) {
+            break;
+        }
+    }
+#else
+    for (; i < candidates; i++) {
+        if (h[i] == x[0] && h[i + last] == x[last]) {
+            if (mini_memcmp(h + i + 1, x + 1, needle_len - 2) == 0) {
+                return (void*)(h + i);
+            }
+            verified += needle_len;
+            if (verified > (long)PREFILTER_BUDGET * (i + 1) + 1024) {
+                break;
+            }
+        }
+    }
+#endif
+    if (i >= candidates) {
+        return NULL;
+    }
+    return (void*)two_way(h + i, haystack_len - i, x, needle_len);
+}
+
+char* mini_strstr(char* haystack, char* needle) {
+    if (haystack == NULL || needle == NULL) {
+        return NULL;
+    }
+    return (char*)mini_memmem(haystack, mini_strlen(haystack), needle, mini_strlen(needle));
+}
+
+MINI_AC* mini_ac_new(char** patterns, int count) {
+    if (patterns == NULL || count <= 0) {
+        return NULL;
+    }
+    // Au plus un état par octet de motif, plus la racine
+    int max_states = 1;
+    for (int k = 0; k < count; k++) {
+        if (patterns[k] == NULL || patterns[k][0] == '\0') {
+            return NULL;
+        }
+        max_states += mini_strlen(patterns[k]);
+    }
+
+    MINI_AC* ac = (MINI_AC*)mini_calloc(sizeof(MINI_AC), 1);
+    if (ac == NULL) {
+        return NULL;
+    }
+    ac->next = (int*)mini_calloc(sizeof(int), max_states * AC_ALPHABET);
+    ac->output = (int*)mini_calloc(sizeof(int), max_states);
+    ac->output_link = (int*)mini_calloc(sizeof(int), max_states);
+    ac->lengths = (int*)mini_calloc(sizeof(int), count);
+    ac->duplicate = (int*)mini_calloc(sizeof(int), count);
+    int* fail = (int*)mini_calloc(sizeof(int), max_states);
+    int* queue = (int*)mini_calloc(sizeof(int), max_states);
+    if (!ac->next || !ac->output || !ac->output_link || !ac->lengths || !ac->duplicate || !fail || !queue) {
+        if (fail) mini_free(fail);
+        if (queue) mini_free(queue);
+        mini_ac_free(ac);
+        return NULL;
+    }
+    ac->pattern_count = count;
+    ac->state_count = 1;
+
+    // Construction du trie ; next[] == 0 signifie « pas de transition »
+    for (int s = 0; s < max_states; s++) {
+        ac->output[s] = -1;
+        ac->output_link[s] = -1;
+    }
+    for (int k = 0; k < count; k++) {
+        const unsigned char* c = (const unsigned char*)patterns[k];
+        int state = 0;
+        for (; *c; c++) {
+            int* slot = &ac->next[state * AC_ALPHABET + *c];
+            if (*slot == 0) {
+                *slot = ac->state_count++;
+            }
+            state = *slot;
+        }
+        // Les motifs de même texte partagent l'état : chaînés dans l'ordre
+        ac->duplicate[k] = -1;
+        int* last = &ac->output[state];
+        while (*last != -1) {
+            last = &ac->duplicate[*last];
+        }
+        *last = k;
+        ac->lengths[k] = mini_strlen(patterns[k]);
+    }
+
+    // Parcours en largeur : liens d'échec, et automate complété pour que
+    // chaque octet lu coûte exactement une transition
+    int head = 0, tail = 0;
+    for (int c = 0; c < AC_ALPHABET; c++) {
+        int child = ac->next[c];
+        if (child) {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        int state = queue[head++];
+        int f = fail[state];
+        ac->output_link[state] = ac->output[f] != -1 ? f : ac->output_link[f];
+        for (int c = 0; c < AC_ALPHABET; c++) {
+            int* slot = &ac->next[state * AC_ALPHABET + c];
+            if (*slot) {
+                fail[*slot] = ac->next[f * AC_ALPHABET + c];
+                queue[tail++] = *slot;
+            } else {
+                *slot = ac->next[f * AC_ALPHABET + c];
+            }
+        }
+    }
+
+    mini_free(fail);
+    mini_free(queue);
+    return ac;
+}
+
+int mini_ac_scan(MINI_AC* ac, const void* buffer, int len,
+                 int (*on_match)(int pattern, int start, void* ctx), void* ctx) {
+    if (ac == NULL || buffer == NULL || len < 0) {
+        return -1;
+    }
+    const unsigned char* p = (const unsigned char*)buffer;
+    int state = 0;
+    int matches = 0;
+    for (int i = 0; i < len; i++) {
+        state = ac->next[state * AC_ALPHABET + p[i]];
+        int hit = ac->output[state] != -1 ? state : ac->output_link[state];
+        while (hit != -1) {
+            for (int k = ac->output[hit]; k != -1; k = ac->duplicate[k]) {
+                matches++;
+                if (on_match && on_match(k, i + 1 - ac->lengths[k], ctx)) {
+                    return matches;
+                }
+            }
+            hit = ac->output_link[hit];
+        }
+    }
+    return matches;
+}
+
+void mini_ac_free(MINI_AC* ac) {
+    if (ac == NULL) {
+        return;
+    }
+    if (ac->next) mini_free(ac->next);
+    if (ac->output) mini_free(ac->output);
+    if (ac->output_link) mini_free(ac->output_link);
+    if (ac->lengths) mini_free(ac->lengths);
+    if (ac->duplicate) mini_free(ac->duplicate);
+    mini_free(ac);
+}
@@ -0,0 +1,132 @@
+//include standart library
+#include <limits.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+//include personal library
+#include "mini_lib.h"
+
+//define constant
+#define STRBUF_MIN_CAPACITY 64
+
+void mini_strbuf_init(mini_strbuf* sb) {
+    if (sb == NULL) {
+        return;
+    }
+    sb->data = NULL;
+    sb->len = 0;
+    sb->capacity = 0;
+}
+
+int mini_strbuf_reserve(mini_strbuf* sb, int extra) {
+    if (sb == NULL || extra < 0) {
+        return -1;
+    }
+    // Un octet de réserve pour le '\0' final de mini_strbuf_cstr
+    if (extra > INT_MAX - 1 - sb->len) {
+        return -1;
+    }
+    int needed = sb->len + extra + 1;
+    if (needed <= sb->capacity) {
+        return 0;
+    }
+    // Croissance géométrique : ajouts en O(1) amorti ; taille exacte quand
+    // doubler dépasserait INT_MAX
+    int capacity = sb->capacity ? sb->capacity : STRBUF_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity = capacity > INT_MAX / 2 ? needed : capacity * 2;
+    }
+    char* data = (char*)mini_calloc(sizeof(char), capacity);
+    if (data == NULL) {
+        return -1;
+    }
+    if (sb->data) {
+        mini_memcpy(data, sb->data, sb->len);
+        mini_free(sb->data);
+    }
+    sb->data = data;
+    sb->capacity = capacity;
+    return 0;
+}
+
+int mini_strbuf_append(mini_strbuf* sb, const void* data, int len) {
+    if (sb == NULL || data == NULL || len < 0) {
+        return -1;
+    }
+    if (mini_strbuf_reserve(sb, len) == -1) {
+        return -1;
+    }
+    mini_memcpy(sb->data + sb->len, data, len);
+    sb->len += len;
+    return len;
+}
+
+int mini_strbuf_append_str(mini_strbuf* sb, char* s) {
+    if (s == NULL) {
+        return -1;
+    }
+    return mini_strbuf_append(sb, s, mini_strlen(s));
+}
+
+int mini_strbuf_append_char(mini_strbuf* sb, char c) {
+    if (sb == NULL || mini_strbuf_reserve(sb, 1) == -1) {
+        return -1;
+    }
+    sb->data[sb->len++] = c;
+    return 1;
+}
+
+int mini_strbuf_append_int(mini_strbuf* sb, long value) {
+    // Chiffres produits à l'envers dans un petit tampon sur la pile
+    char digits[24];
+    int i = sizeof(digits);
+    unsigned long magnitude = value < 0 ? -(unsigned long)value : (unsigned long)value;
+    do {
+        digits[--i] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[--i] = '-';
+    }
+    return mini_strbuf_append(sb, digits + i, (int)sizeof(digits) - i);
+}
+
+char* mini_strbuf_cstr(mini_strbuf* sb) {
+    if (sb == NULL || mini_strbuf_reserve(sb, 0) == -1) {
+        return NULL;
+    }
+    sb->data[sb->len] = '\0';
+    return sb->data;
+}
+
+void mini_strbuf_clear(mini_strbuf* sb) {
+    if (sb) {
+        sb->len = 0;
+    }
+}
+
+void mini_strbuf_free(mini_strbuf* sb) {
+    if (sb == NULL) {
+        return;
+    }
+    if (sb->data) {
+        mini_free(sb->data);
+    }
+    mini_strbuf_init(sb);
+}
+
+int mini_strbuf_fwrite(mini_strbuf* sb, MYFILE* file) {
+    if (sb == NULL || sb->len == 0) {
+        return 0;
+    }
+    return mini_fwrite(sb->data, 1, sb->len, file);
+}
+
+struct iovec mini_strbuf_iov(mini_strbuf* sb) {
+    struct iovec iov = {NULL, 0};
+    if (sb != NULL) {
+        iov.iov_base = sb->data;
+        iov.iov_len = sb->len;
+    }
+    return iov;
+}
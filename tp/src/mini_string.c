@@ -8,45 +8,30 @@
 //include personal library
 #include "mini_lib.h"
 
-//define constant
-#define BUF_SIZE 1024
-
-char* buffer = NULL;
-int ind = -1;
-
+// Les sorties passent par mini_stdout (mini_io.c) : même tampon que
+// mini_fwrite, vidé par ligne sur un terminal et par mini_exit_flush
 void mini_printf(char *str)
 {
     if (str == NULL)
     {
         return;
     }
-    if (ind == -1){
-        buffer = (char*)mini_calloc(sizeof(char), BUF_SIZE);
-        ind = 0;
-    }
-    while (*str) {
-        buffer[ind] = *str;
-        ind++;
-        if (ind == BUF_SIZE || *str == '\n'){
-            int valid = write(STDOUT_FILENO, buffer, BUF_SIZE);
-            if (valid < 0){
-                write(STDERR_FILENO, "write", 5);
-            }
-            ind = 0;
-            mini_memset(buffer,0,BUF_SIZE);
-        }
-        str++;
+    mini_printf_n(str, mini_strlen(str));
+}
+
+// Comme mini_printf, pour une plage d'octets sans '\0' final
+void mini_printf_n(const char *str, int len)
+{
+    if (str == NULL || len <= 0)
+    {
+        return;
     }
+    mini_fwrite((void*)str, 1, len, mini_stdout);
 }
 
+// Conservé pour les appelants existants : le vidage se fait dans mini_exit_flush
 void mini_exit_printf(void){
-    if (ind > 0){
-        int valid = write(STDOUT_FILENO, buffer, ind);
-        if (valid < 0){
-            write(STDERR_FILENO, "write", 5);
-        }
-        ind = -1;
-    }
+    mini_fflush(mini_stdout);
 }
 
 int mini_scanf(char* buffer, int size_buffer){
@@ -59,7 +44,7 @@ int mini_scanf(char* buffer, int size_buffer){
     while(nb_carac < size_buffer)
     {
         
-        if (read(STDIN_FILENO, &c, 1) <= 0) {
+        if (mini_fread(&c, 1, 1, mini_stdin) <= 0) {
             break;
         }
         if (c == '\n') {
@@ -108,9 +93,25 @@ int mini_strcmp(char* s1, char* s2){
     return (*s1 == '\0' && *s2 == '\0') ? 0 : -1;
 }
 
+// Une seule écriture non tamponnée sur mini_stderr. Si cette écriture
+// échoue, mini_fwrite rappelle mini_perror : on n'y retourne pas.
 void mini_perror(char * message){
-    mini_printf(message);
-    mini_printf(" : ");
+    static __thread int reporting = 0;
+    if (reporting) {
+        return;
+    }
+    reporting = 1;
+    char line[256];
+    int len = 0;
+    if (message != NULL) {
+        while (message[len] != '\0' && len < (int)sizeof(line) - 16) {
+            line[len] = message[len];
+            len++;
+        }
+    }
+    line[len++] = ' ';
+    line[len++] = ':';
+    line[len++] = ' ';
     char err_str[12];
     int err_num = errno;
     int i = 0;
@@ -122,15 +123,11 @@ void mini_perror(char * message){
             err_num /= 10;
         }
     }
-    err_str[i] = '\0';
-
-    // Reverse the string
-    for (int j = 0; j < i / 2; j++) {
-        char temp = err_str[j];
-        err_str[j] = err_str[i - j - 1];
-        err_str[i - j - 1] = temp;
+    // Chiffres dans l'ordre inverse
+    while (i > 0) {
+        line[len++] = err_str[--i];
     }
-
-    mini_printf(err_str);
-    mini_printf("\n");
-}
\ No newline at end of file
+    line[len++] = '\n';
+    mini_fwrite(line, 1, len, mini_stderr);
+    reporting = 0;
+}
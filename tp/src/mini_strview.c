@@ -0,0 +1,163 @@
+//include standart library
+#include <limits.h>
+#include <unistd.h>
+
+//include personal library
+#include "mini_lib.h"
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+mini_strview mini_sv(const char* s) {
+    mini_strview sv = {s, 0};
+    if (s != NULL) {
+        sv.len = mini_strlen((char*)s);
+    }
+    return sv;
+}
+
+mini_strview mini_sv_from(const char* data, int len) {
+    mini_strview sv = {data, (data != NULL && len > 0) ? len : 0};
+    return sv;
+}
+
+mini_strview mini_sv_sub(mini_strview sv, int start, int len) {
+    if (start < 0) start = 0;
+    if (start > sv.len) start = sv.len;
+    if (len < 0 || len > sv.len - start) len = sv.len - start;
+    return mini_sv_from(sv.data + start, len);
+}
+
+mini_strview mini_sv_trim_left(mini_strview sv) {
+    while (sv.len > 0 && is_space(*sv.data)) {
+        sv.data++;
+        sv.len--;
+    }
+    return sv;
+}
+
+mini_strview mini_sv_trim_right(mini_strview sv) {
+    while (sv.len > 0 && is_space(sv.data[sv.len - 1])) {
+        sv.len--;
+    }
+    return sv;
+}
+
+mini_strview mini_sv_trim(mini_strview sv) {
+    return mini_sv_trim_right(mini_sv_trim_left(sv));
+}
+
+int mini_sv_find_char(mini_strview sv, char c) {
+    const char* hit = (const char*)mini_memchr(sv.data, c, sv.len);
+    return hit ? (int)(hit - sv.data) : -1;
+}
+
+int mini_sv_find(mini_strview sv, mini_strview needle) {
+    if (sv.data == NULL) {
+        return needle.len == 0 ? 0 : -1;
+    }
+    const char* hit = (const char*)mini_memmem(sv.data, sv.len, needle.data ? needle.data : "", needle.len);
+    return hit ? (int)(hit - sv.data) : -1;
+}
+
+int mini_sv_cmp(mini_strview a, mini_strview b) {
+    int n = a.len < b.len ? a.len : b.len;
+    int diff = mini_memcmp(a.data, b.data, n);
+    if (diff != 0) {
+        return diff;
+    }
+    return a.len - b.len;
+}
+
+int mini_sv_equals(mini_strview a, char* s) {
+    return mini_sv_cmp(a, mini_sv(s)) == 0;
+}
+
+int mini_sv_starts_with(mini_strview sv, mini_strview prefix) {
+    return prefix.len <= sv.len && mini_memcmp(sv.data, prefix.data, prefix.len) == 0;
+}
+
+int mini_sv_split(mini_strview sv, char delim, mini_strview* head, mini_strview* tail) {
+    int at = mini_sv_find_char(sv, delim);
+    if (at < 0) {
+        if (head) *head = sv;
+        if (tail) *tail = mini_sv_from(sv.data + sv.len, 0);
+        return 0;
+    }
+    if (head) *head = mini_sv_from(sv.data, at);
+    if (tail) *tail = mini_sv_from(sv.data + at + 1, sv.len - at - 1);
+    return 1;
+}
+
+int mini_sv_to_int(mini_strview sv, int* value) {
+    if (value == NULL || sv.len == 0) {
+        return -1;
+    }
+    int i = 0, negative = 0, result = 0;
+    if (sv.data[0] == '-' || sv.data[0] == '+') {
+        negative = sv.data[0] == '-';
+        i++;
+    }
+    if (i == sv.len) {
+        return -1;
+    }
+    // Accumulé en négatif pour atteindre INT_MIN ; une valeur hors limites
+    // est refusée avant la multiplication
+    for (; i < sv.len; i++) {
+        if (sv.data[i] < '0' || sv.data[i] > '9') {
+            return -1;
+        }
+        int digit = sv.data[i] - '0';
+        if (result < INT_MIN / 10 || result * 10 < INT_MIN + digit) {
+            return -1;
+        }
+        result = result * 10 - digit;
+    }
+    if (!negative && result == INT_MIN) {
+        return -1;
+    }
+    *value = negative ? result : -result;
+    return 0;
+}
+
+void mini_tok_init(mini_tokenizer* tok, mini_strview sv, char* delims) {
+    if (tok == NULL) {
+        return;
+    }
+    tok->rest = sv;
+    // Un bit par valeur d'octet : chaque test de délimiteur est une seule lecture
+    for (int i = 0; i < 32; i++) {
+        tok->delims[i] = 0;
+    }
+    for (unsigned char* d = (unsigned char*)delims; d && *d; d++) {
+        tok->delims[*d >> 3] |= (unsigned char)(1 << (*d & 7));
+    }
+}
+
+static int is_delim(const mini_tokenizer* tok, unsigned char c) {
+    return tok->delims[c >> 3] & (1 << (c & 7));
+}
+
+int mini_tok_next(mini_tokenizer* tok, mini_strview* token) {
+    if (tok == NULL || token == NULL) {
+        return 0;
+    }
+    const char* p = tok->rest.data;
+    const char* end = p + tok->rest.len;
+    // Les délimiteurs consécutifs sont sautés, jamais de jeton vide
+    while (p < end && is_delim(tok, (unsigned char)*p)) {
+        p++;
+    }
+    if (p == end) {
+        tok->rest = mini_sv_from(end, 0);
+        return 0;
+    }
+    const char* start = p;
+    while (p < end && !is_delim(tok, (unsigned char)*p)) {
+        p++;
+    }
+    *token = mini_sv_from(start, (int)(p - start));
+    tok->rest = mini_sv_from(p, (int)(end - p));
+    return 1;
+}
@@ -0,0 +1,253 @@
+//include standart library
+#include <unistd.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+//include personal library
+#include "mini_lib.h"
+
+// Décode un point de code, retourne sa longueur en octets ou -1 si la
+// séquence est invalide (trop longue, surrogate, au-delà de U+10FFFF ou tronquée)
+static int decode_one(const unsigned char* s, int len, int* cp) {
+    unsigned char c = s[0];
+    int n, value;
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        n = 2;
+        value = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        n = 3;
+        value = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        n = 4;
+        value = c & 0x07;
+    } else {
+        return -1;
+    }
+    if (len < n) {
+        return -1;
+    }
+    for (int i = 1; i < n; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return -1;
+        }
+        value = (value << 6) | (s[i] & 0x3F);
+    }
+    if ((n == 3 && value < 0x800) || (n == 4 && (value < 0x10000 || value > 0x10FFFF))
+        || (value >= 0xD800 && value <= 0xDFFF)) {
+        return -1;
+    }
+    *cp = value;
+    return n;
+}
+
+static int validate_scalar(const unsigned char* s, int len) {
+    int i = 0, cp;
+    while (i < len) {
+        int n = decode_one(s + i, len - i, &cp);
+        if (n < 0) {
+            return 0;
+        }
+        i += n;
+    }
+    return 1;
+}
+
+#ifdef __x86_64__
+// Validation par tables (Keiser et Lemire) : chaque paire d'octets est classée
+// par trois tables de 16 entrées, les séquences de 3 et 4 octets sont vérifiées
+// par soustractions saturées. Aucun branchement par octet hors ASCII.
+#define TOO_SHORT   (1 << 0)
+#define TOO_LONG    (1 << 1)
+#define OVERLONG_3  (1 << 2)
+#define TOO_LARGE   (1 << 3)
+#define SURROGATE   (1 << 4)
+#define OVERLONG_2  (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4  (1 << 6)
+#define TWO_CONTS   (1 << 7)
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__((target("ssse3")))
+static __m128i check_block(__m128i input, __m128i prev_input) {
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY, CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table,
+                                           _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low_nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table,
+                                           _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+    // Octets qui doivent être la 2e ou 3e suite d'une séquence de 3 ou 4 octets
+    __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))),
+                                  _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80))));
+    __m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23_80, special);
+}
+
+__attribute__((target("ssse3")))
+static int validate_ssse3(const unsigned char* s, int len) {
+    // Une séquence encore ouverte en fin de bloc doit être complétée par le suivant
+    const __m128i max_value = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    int i = 0;
+    for (; i < len; i += 16) {
+        __m128i input;
+        if (i + 16 <= len) {
+            input = _mm_loadu_si128((const __m128i*)(s + i));
+        } else {
+            // Fin complétée par des zéros, qui sont de l'ASCII simple
+            unsigned char tail[16] = {0};
+            mini_memcpy(tail, s + i, len - i);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            error = _mm_or_si128(error, check_block(input, prev_input));
+            prev_incomplete = _mm_subs_epu8(input, max_value);
+        }
+        prev_input = input;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+int mini_utf8_validate(const void* s, int len) {
+    if (s == NULL || len < 0) {
+        return 0;
+    }
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("ssse3")) {
+        return validate_ssse3((const unsigned char*)s, len);
+    }
+#endif
+    return validate_scalar((const unsigned char*)s, len);
+}
+
+int mini_utf8_count(const void* s, int len) {
+    if (s == NULL || len < 0) {
+        return -1;
+    }
+    const unsigned char* p = (const unsigned char*)s;
+    int count = 0, i = 0;
+#ifdef __SSE2__
+    // Chaque octet qui n'est pas une suite (10xxxxxx) commence un point de code ;
+    // en valeurs signées, les octets de suite sont exactement ceux <= -65
+    const __m128i limit = _mm_set1_epi8(-65);
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(block, limit)));
+    }
+#endif
+    for (; i < len; i++) {
+        count += (p[i] & 0xC0) != 0x80;
+    }
+    return count;
+}
+
+// Largeur en colonnes d'un point de code : 0 pour les contrôles et les
+// diacritiques combinants, 2 pour les caractères larges d'Asie de l'Est, 1 sinon
+static int codepoint_width(int cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (cp < 0x0300) return 1;
+    if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x200B && cp <= 0x200F)
+        || (cp >= 0x20D0 && cp <= 0x20FF) || (cp >= 0xFE00 && cp <= 0xFE0F)
+        || (cp >= 0xFE20 && cp <= 0xFE2F)) return 0;
+    if ((cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0x303E)
+        || (cp >= 0x3041 && cp <= 0x33FF) || (cp >= 0x3400 && cp <= 0x4DBF)
+        || (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xA000 && cp <= 0xA4CF)
+        || (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF)
+        || (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60)
+        || (cp >= 0xFFE0 && cp <= 0xFFE6) || (cp >= 0x1F300 && cp <= 0x1F64F)
+        || (cp >= 0x1F900 && cp <= 0x1F9FF) || (cp >= 0x20000 && cp <= 0x3FFFD)) return 2;
+    return 1;
+}
+
+// Parcourt s jusqu'à ce que la largeur cumulée dépasse max_width (sans limite
+// si < 0), range la largeur atteinte et retourne les octets lus, -1 si invalide
+static int measure(const unsigned char* s, int len, int max_width, int* width) {
+    int i = 0, w = 0, cp;
+    while (i < len) {
+#ifdef __SSE2__
+        // Une suite d'ASCII imprimable fait une colonne par octet : sautée d'un coup
+        if (i + 16 <= len) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(0x1F)),
+                                              _mm_cmplt_epi8(block, _mm_set1_epi8(0x7F)));
+            int run = __builtin_ctz(~_mm_movemask_epi8(printable));
+            if (run > 0 && (max_width < 0 || w + run <= max_width)) {
+                i += run;
+                w += run;
+                continue;
+            }
+        }
+#endif
+        int n = decode_one(s + i, len - i, &cp);
+        if (n < 0) {
+            return -1;
+        }
+        int cw = codepoint_width(cp);
+        if (max_width >= 0 && w + cw > max_width) {
+            break;
+        }
+        w += cw;
+        i += n;
+    }
+    *width = w;
+    return i;
+}
+
+int mini_utf8_width(const void* s, int len) {
+    if (s == NULL || len < 0) {
+        return -1;
+    }
+    int width;
+    if (measure((const unsigned char*)s, len, -1, &width) < 0) {
+        return -1;
+    }
+    return width;
+}
+
+int mini_utf8_truncate(const void* s, int len, int max_width) {
+    if (s == NULL || len < 0 || max_width < 0) {
+        return -1;
+    }
+    int width;
+    return measure((const unsigned char*)s, len, max_width, &width);
+}
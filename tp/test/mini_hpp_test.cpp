@@ -0,0 +1,91 @@
+/**
+ * @file mini_hpp_test.cpp
+ * @brief Compile-and-behaviour test of the C++20 front-end (mini_lib.hpp).
+ *
+ * Built and run by "make test_hpp" against the C objects of the library:
+ * - Test 1: every conversion through mini::format_to.
+ * - Test 2: "%%", empty format and literal-only formats.
+ * - Test 3: mini::print interleaved with mini_printf on a redirected
+ *   stdout, over several buffer flushes, writes exactly the expected bytes.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include "mini_lib.hpp"
+
+static int failures = 0;
+
+static void check(bool passed, const char* name) {
+    std::printf("%s: %s\n", name, passed ? "passed" : "failed");
+    if (!passed) failures++;
+}
+
+static void test_format_to() {
+    mini_strbuf sb;
+    mini_strbuf_init(&sb);
+    const char* name = "file";
+    char mutable_name[] = "dir";
+    int status = mini::format_to<"%s/%s: %d files, %u bytes, mask %x%c">(
+        sb, mutable_name, name, -42, 4096u, 0xbeefu, '\n');
+    status |= mini::format_to<"[%d %d %s]">(sb, INT_MIN, 0LL, mini_sv("view"));
+    check(status == 0 && std::strcmp(mini_strbuf_cstr(&sb),
+                                     "dir/file: -42 files, 4096 bytes, mask beef\n[-2147483648 0 view]") == 0,
+          "Test 1 - All conversions");
+
+    mini_strbuf_clear(&sb);
+    status = mini::format_to<"100%%">(sb);
+    status |= mini::format_to<"">(sb);
+    status |= mini::format_to<" %x">(sb, -1);
+    check(status == 0 && std::strcmp(mini_strbuf_cstr(&sb), "100% ffffffff") == 0,
+          "Test 2 - Literals and negative hexadecimal");
+    mini_strbuf_free(&sb);
+}
+
+static void test_print() {
+    const char* path = "test_hpp_stdout.txt";
+    int saved = dup(1);
+    int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    mini_fflush(mini_stdout);
+    dup2(fd, 1);
+    close(fd);
+
+    // Segments of different lengths so that flushes fall anywhere in a line
+    mini_strbuf expected;
+    mini_strbuf_init(&expected);
+    for (int i = 0; i < 3000; i++) {
+        mini::print<"%d:%s|">(i, "abc");
+        mini_printf((char*)"xy\n");
+        mini::format_to<"%d:%s|xy\n">(expected, i, "abc");
+    }
+    mini_fflush(mini_stdout);
+    dup2(saved, 1);
+    close(saved);
+
+    mini_strbuf got;
+    mini_strbuf_init(&got);
+    char chunk[4096];
+    fd = open(path, O_RDONLY);
+    int n;
+    while ((n = (int)read(fd, chunk, sizeof(chunk))) > 0) mini_strbuf_append(&got, chunk, n);
+    close(fd);
+    unlink(path);
+    check(got.len == expected.len && std::memcmp(got.data, expected.data, got.len) == 0,
+          "Test 3 - print and mini_printf interleaved");
+    mini_strbuf_free(&got);
+    mini_strbuf_free(&expected);
+}
+
+int main() {
+    test_format_to();
+    test_print();
+    if (failures) {
+        std::printf("%d test(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All tests passed!\n");
+    return 0;
+}